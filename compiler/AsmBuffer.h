@@ -0,0 +1,43 @@
+#pragma once
+
+#include <charconv>
+#include <concepts>
+#include <ostream>
+#include <string>
+#include <string_view>
+
+// Assembly text of a function, appended to one buffer and written to the output in a single call once the
+// function is complete. Integers are formatted with std::to_chars, without the locale and the sentry of an
+// std::ostream for each piece of text.
+class AsmBuffer {
+  public:
+    AsmBuffer& operator<<(std::string_view text) {
+        m_text.append(text);
+        return *this;
+    }
+
+    AsmBuffer& operator<<(char c) {
+        m_text.push_back(c);
+        return *this;
+    }
+
+    // Unlike std::ostream, an uint8_t is printed as a number and not as a character
+    template <std::integral T>
+    AsmBuffer& operator<<(T value) {
+        char digits[24];
+        auto end = std::to_chars(digits, digits + sizeof(digits), value).ptr;
+        m_text.append(digits, end);
+        return *this;
+    }
+
+    size_t size() const { return m_text.size(); }
+
+    // Write the buffer to out and empty it, its capacity is kept for the next function
+    void flush(std::ostream& out) {
+        out.write(m_text.data(), m_text.size());
+        m_text.clear();
+    }
+
+  private:
+    std::string m_text;
+};
@@ -0,0 +1,54 @@
+#include "BackgroundWriter.h"
+
+#include <fstream>
+#include <iostream>
+
+BackgroundWriter::BackgroundWriter() : m_thread(&BackgroundWriter::run, this) {}
+
+BackgroundWriter::~BackgroundWriter() {
+    {
+        std::lock_guard lock(m_mutex);
+        m_stopping = true;
+    }
+    m_queued.notify_one();
+    m_thread.join();
+}
+
+void BackgroundWriter::push(Job job) {
+    std::unique_lock lock(m_mutex);
+    // A single text larger than the limit is still accepted once the queue is empty
+    m_written.wait(lock, [&] { return m_pendingBytes == 0 || m_pendingBytes + job.text.size() <= MAX_PENDING_BYTES; });
+    m_pendingBytes += job.text.size();
+    m_jobs.push_back(std::move(job));
+    lock.unlock();
+    m_queued.notify_one();
+}
+
+void BackgroundWriter::run() {
+    std::unique_lock lock(m_mutex);
+    while (true) {
+        m_queued.wait(lock, [&] { return !m_jobs.empty() || m_stopping; });
+        // The queue is emptied before stopping
+        if (m_jobs.empty()) {
+            return;
+        }
+
+        Job job = std::move(m_jobs.front());
+        m_jobs.pop_front();
+        lock.unlock();
+
+        if (job.out) {
+            job.out->write(job.text.data(), job.text.size());
+            job.out->flush();
+        } else {
+            std::ofstream file(job.path);
+            if (!file.write(job.text.data(), job.text.size())) {
+                std::cerr << "error: cannot write file: " << job.path << std::endl;
+            }
+        }
+
+        lock.lock();
+        m_pendingBytes -= job.text.size();
+        m_written.notify_all();
+    }
+}
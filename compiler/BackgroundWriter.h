@@ -0,0 +1,70 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <mutex>
+#include <ostream>
+#include <sstream>
+#include <string>
+#include <thread>
+
+// Writes the dumps of -dump-ir and -dump-cfg on a thread of its own, so the compilation does not wait for
+// the disk or the terminal. Texts are written in the order they are queued, and the destructor waits until
+// every text is written. Compiling threads only block when more than MAX_PENDING_BYTES are waiting.
+class BackgroundWriter {
+  public:
+    static constexpr size_t MAX_PENDING_BYTES = 64 * 1024 * 1024;
+
+    BackgroundWriter();
+    BackgroundWriter(const BackgroundWriter&) = delete;
+    BackgroundWriter& operator=(const BackgroundWriter&) = delete;
+    ~BackgroundWriter();
+
+    // out must only be written by this writer, or be one of the standard streams
+    void write(std::ostream& out, std::string text) { push({&out, {}, std::move(text)}); }
+
+    // Create or replace the file at path. An error is printed to std::cerr if it cannot be written
+    void writeFile(std::string path, std::string text) { push({nullptr, std::move(path), std::move(text)}); }
+
+  private:
+    struct Job {
+        // Null when the text goes to the file at path
+        std::ostream* out;
+        std::string path;
+        std::string text;
+    };
+
+    std::deque<Job> m_jobs;
+    size_t m_pendingBytes = 0;
+    bool m_stopping = false;
+    std::mutex m_mutex;
+    // Signaled when a job is queued, and when the writer is stopping
+    std::condition_variable m_queued;
+    // Signaled when a job is written
+    std::condition_variable m_written;
+    std::thread m_thread;
+
+    void push(Job job);
+    void run();
+};
+
+// Diagnostics of a file written by a BackgroundWriter, so they stay in order with the IR dumped to the same
+// stream. The text is queued each time the stream is flushed, by std::endl for example, and when it is destroyed
+class BackgroundLog : private std::stringbuf, public std::ostream {
+  public:
+    BackgroundLog(BackgroundWriter& writer, std::ostream& out) : std::ostream(this), m_writer(writer), m_out(out) {}
+    ~BackgroundLog() override { sync(); }
+
+  private:
+    BackgroundWriter& m_writer;
+    std::ostream& m_out;
+
+    int sync() override {
+        if (!view().empty()) {
+            m_writer.write(m_out, std::move(*this).str());
+            str({});
+        }
+        return 0;
+    }
+};
@@ -6,6 +6,10 @@
 using namespace ir;
 
 void BlockLivenessAnalysisVisitor::visit(ir::Function& function) {
+    size_t blockCount = function.indexBlocks();
+    m_liveMap = BlockLivenessAnalysis(blockCount, function.locals().size());
+    m_workingSet = LiveSet(function.locals().size());
+
     std::vector<BasicBlock*> toVisit;
     // Push all block to be sure they are all visited at least once
     toVisit.push_back(function.prologue());
@@ -14,7 +18,7 @@ void BlockLivenessAnalysisVisitor::visit(ir::Function& function) {
         [](auto& block) { return block.get(); }
     );
     toVisit.push_back(function.epilogue());
-    m_liveMap[function.epilogue()].second = {function.returnLocal()};
+    m_liveMap[function.epilogue()].second.insert(function.returnLocal());
     while (!toVisit.empty()) {
         BasicBlock* current = toVisit.back();
         toVisit.pop_back();
@@ -1,12 +1,25 @@
 #pragma once
 
 #include "BlockDependance.h"
-#include "InterferenceGraph.h"
+#include "LiveSet.h"
 #include "ir/Ir.h"
-#include <unordered_set>
+#include <unordered_map>
+#include <vector>
 
-using LiveSet = std::unordered_set<ir::Local>;
-using BlockLivenessAnalysis = std::unordered_map<ir::BasicBlock*, std::pair<LiveSet, LiveSet>>;
+// Live locals at the input (first) and at the output (second) of every block of a function.
+// Stored in a vector indexed by BasicBlock::index(), so Function::indexBlocks must have been called.
+class BlockLivenessAnalysis {
+  public:
+    BlockLivenessAnalysis() = default;
+    BlockLivenessAnalysis(size_t blockCount, size_t localCount) :
+        m_blocks(blockCount, {LiveSet(localCount), LiveSet(localCount)}) {}
+
+    auto& operator[](const ir::BasicBlock* block) { return m_blocks.at(block->index()); }
+    const auto& operator[](const ir::BasicBlock* block) const { return m_blocks.at(block->index()); }
+
+  private:
+    std::vector<std::pair<LiveSet, LiveSet>> m_blocks;
+};
 
 using LocalsUsedThroughCalls = std::unordered_map<const ir::Instruction*, std::pair<LiveSet, LiveSet>>;
 
@@ -14,12 +27,8 @@ class BlockLivenessAnalysisVisitor : public ir::Visitor {
   public:
     using ir::Visitor::visit;
 
-    BlockLivenessAnalysisVisitor(
-        DependanceMap& dependanceMap, InterferenceGraph* interferenceGraph = nullptr,
-        LocalsUsedThroughCalls* calls = nullptr
-    ) :
-        m_dependanceMap(dependanceMap),
-        m_interferenceGraph(interferenceGraph), m_calls(calls) {}
+    BlockLivenessAnalysisVisitor(DependanceMap& dependanceMap, LocalsUsedThroughCalls* calls = nullptr) :
+        m_dependanceMap(dependanceMap), m_calls(calls) {}
 
     void visit(ir::Function& function) override;
     void visit(ir::BasicBlock& block) override;
@@ -38,7 +47,6 @@ class BlockLivenessAnalysisVisitor : public ir::Visitor {
   private:
     BlockLivenessAnalysis m_liveMap;
     DependanceMap& m_dependanceMap;
-    InterferenceGraph* m_interferenceGraph;
     LocalsUsedThroughCalls* m_calls;
 
     LiveSet m_workingSet;
@@ -53,52 +61,29 @@ class BlockLivenessAnalysisVisitor : public ir::Visitor {
             unsetLive(std::get<ir::Local>(rvalue));
     }
 
-    void setLive(ir::Local local) {
-        if (m_workingSet.insert(local).second && m_interferenceGraph) {
-            for (const auto& other : m_workingSet) {
-                m_interferenceGraph->addInterference(local.id(), other.id());
-            }
-        }
-    }
+    void setLive(ir::Local local) { m_workingSet.insert(local); }
 
     void unsetLive(ir::Local local) { m_workingSet.erase(local); }
 
     bool propagate(ir::BasicBlock* source, ir::BasicBlock* target) {
         LiveSet& sourceSet = m_liveMap[source].first;
         LiveSet& targetSet = m_liveMap[target].second;
-
-        bool changed = false;
-        for (auto local : sourceSet) {
-            bool inserted = targetSet.insert(local).second;
-            changed |= inserted;
-            if (inserted && m_interferenceGraph) {
-                for (const auto& other : targetSet) {
-                    m_interferenceGraph->addInterference(local.id(), other.id());
-                }
-            }
-        }
-
-        return changed;
+        return targetSet.unionWith(sourceSet);
     }
 
     bool flushBlockInput(ir::BasicBlock* block) {
         LiveSet& inputSet = m_liveMap[block].first;
 
-        bool changed = false;
-        for (auto local : m_workingSet) {
-            changed |= inputSet.insert(local).second;
-        }
-
+        bool changed = inputSet.unionWith(m_workingSet);
         m_workingSet.clear();
         return changed;
     }
 };
 
 inline BlockLivenessAnalysis computeBlockLivenessAnalysis(
-    ir::Function& function, DependanceMap& dependanceMap, InterferenceGraph* interferenceGraph = nullptr,
-    LocalsUsedThroughCalls* calls = nullptr
+    ir::Function& function, DependanceMap& dependanceMap, LocalsUsedThroughCalls* calls = nullptr
 ) {
-    BlockLivenessAnalysisVisitor visitor{dependanceMap, interferenceGraph, calls};
+    BlockLivenessAnalysisVisitor visitor{dependanceMap, calls};
     visitor.visit(function);
 
     auto analysis = std::move(visitor.blocksLiveness());
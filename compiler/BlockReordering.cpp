@@ -4,6 +4,11 @@ using namespace ir;
 
 void BlockReorderingVisitor::visit(Function& function) {
     m_currentFunction = &function;
+    std::vector<BasicBlock*> previousOrder;
+    for (auto& block : function.blocks()) {
+        previousOrder.push_back(block.get());
+    }
+
     visitBase(*function.prologue()->terminator());
     while (!m_toVisit.empty()) {
         auto current = std::move(m_toVisit.back());
@@ -16,6 +21,7 @@ void BlockReorderingVisitor::visit(Function& function) {
     }
 
     function.blocks().swap(m_finalBlocks);
+    m_changed = !std::ranges::equal(previousOrder, function.blocks(), {}, {}, [](auto& block) { return block.get(); });
 }
 
 void BlockReorderingVisitor::visit(BasicJump& jump) {
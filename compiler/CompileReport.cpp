@@ -0,0 +1,206 @@
+#include "CompileReport.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstdlib>
+#include <ctime>
+#include <iomanip>
+#include <new>
+#include <sys/resource.h>
+
+namespace {
+    // Off unless -fmem-report asks for it, an allocation then only pays for one relaxed load
+    std::atomic<bool> countingAllocations = false;
+    thread_local size_t allocationCount = 0;
+    thread_local size_t allocatedBytes = 0;
+
+    double milliseconds(std::chrono::nanoseconds duration) {
+        return std::chrono::duration<double, std::milli>(duration).count();
+    }
+
+    void* allocate(size_t size, size_t alignment) {
+        if (countingAllocations.load(std::memory_order_relaxed)) {
+            allocationCount++;
+            allocatedBytes += size;
+        }
+
+        if (size == 0)
+            size = 1;
+        // aligned_alloc needs a multiple of the alignment
+        if (alignment > __STDCPP_DEFAULT_NEW_ALIGNMENT__)
+            size = (size + alignment - 1) / alignment * alignment;
+
+        while (true) {
+            void* ptr = alignment > __STDCPP_DEFAULT_NEW_ALIGNMENT__ ? std::aligned_alloc(alignment, size)
+                                                                      : std::malloc(size);
+            if (ptr)
+                return ptr;
+
+            std::new_handler handler = std::get_new_handler();
+            if (!handler)
+                throw std::bad_alloc();
+            handler();
+        }
+    }
+
+    void* allocateNothrow(size_t size, size_t alignment) noexcept {
+        try {
+            return allocate(size, alignment);
+        } catch (const std::bad_alloc&) {
+            return nullptr;
+        }
+    }
+}
+
+// Every allocation of the compiler goes through these so -fmem-report can count them. All the versions are
+// replaced, otherwise the ones of the C++ library or of the sanitizer runtime would not be counted
+void* operator new(size_t size) { return allocate(size, __STDCPP_DEFAULT_NEW_ALIGNMENT__); }
+void* operator new[](size_t size) { return allocate(size, __STDCPP_DEFAULT_NEW_ALIGNMENT__); }
+void* operator new(size_t size, std::align_val_t alignment) { return allocate(size, size_t(alignment)); }
+void* operator new[](size_t size, std::align_val_t alignment) { return allocate(size, size_t(alignment)); }
+void* operator new(size_t size, const std::nothrow_t&) noexcept {
+    return allocateNothrow(size, __STDCPP_DEFAULT_NEW_ALIGNMENT__);
+}
+void* operator new[](size_t size, const std::nothrow_t&) noexcept {
+    return allocateNothrow(size, __STDCPP_DEFAULT_NEW_ALIGNMENT__);
+}
+void* operator new(size_t size, std::align_val_t alignment, const std::nothrow_t&) noexcept {
+    return allocateNothrow(size, size_t(alignment));
+}
+void* operator new[](size_t size, std::align_val_t alignment, const std::nothrow_t&) noexcept {
+    return allocateNothrow(size, size_t(alignment));
+}
+
+void operator delete(void* ptr) noexcept { std::free(ptr); }
+void operator delete[](void* ptr) noexcept { std::free(ptr); }
+void operator delete(void* ptr, size_t) noexcept { std::free(ptr); }
+void operator delete[](void* ptr, size_t) noexcept { std::free(ptr); }
+void operator delete(void* ptr, std::align_val_t) noexcept { std::free(ptr); }
+void operator delete[](void* ptr, std::align_val_t) noexcept { std::free(ptr); }
+void operator delete(void* ptr, size_t, std::align_val_t) noexcept { std::free(ptr); }
+void operator delete[](void* ptr, size_t, std::align_val_t) noexcept { std::free(ptr); }
+void operator delete(void* ptr, const std::nothrow_t&) noexcept { std::free(ptr); }
+void operator delete[](void* ptr, const std::nothrow_t&) noexcept { std::free(ptr); }
+void operator delete(void* ptr, std::align_val_t, const std::nothrow_t&) noexcept { std::free(ptr); }
+void operator delete[](void* ptr, std::align_val_t, const std::nothrow_t&) noexcept { std::free(ptr); }
+
+void countAllocations() { countingAllocations.store(true, std::memory_order_relaxed); }
+
+std::chrono::nanoseconds threadCpuTime() {
+    timespec time;
+    clock_gettime(CLOCK_THREAD_CPUTIME_ID, &time);
+    return std::chrono::seconds(time.tv_sec) + std::chrono::nanoseconds(time.tv_nsec);
+}
+
+size_t threadAllocationCount() { return allocationCount; }
+size_t threadAllocatedBytes() { return allocatedBytes; }
+
+size_t peakRssKb() {
+    rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    // ru_maxrss is in KiB on Linux
+    return usage.ru_maxrss;
+}
+
+CompileReport::Scope::Scope(CompileReport* report, std::string_view phase) : m_report(report), m_phase(phase) {
+    if (!m_report)
+        return;
+
+    m_allocationsStart = allocationCount;
+    m_allocatedBytesStart = allocatedBytes;
+    m_cpuStart = threadCpuTime();
+    m_wallStart = std::chrono::steady_clock::now();
+}
+
+CompileReport::Scope::~Scope() {
+    if (!m_report)
+        return;
+
+    auto wall = std::chrono::steady_clock::now() - m_wallStart;
+    auto cpu = threadCpuTime() - m_cpuStart;
+    size_t allocations = allocationCount - m_allocationsStart;
+    size_t bytes = allocatedBytes - m_allocatedBytesStart;
+
+    // Looking up the phase may allocate, do it after taking the measures
+    Phase& phase = m_report->phase(m_phase);
+    phase.count++;
+    phase.wall += wall;
+    phase.cpu += cpu;
+    phase.allocations += allocations;
+    phase.allocatedBytes += bytes;
+    phase.peakRssKb = std::max(phase.peakRssKb, peakRssKb());
+}
+
+CompileReport::Phase& CompileReport::phase(std::string_view name) {
+    auto it = std::find_if(m_phases.begin(), m_phases.end(), [name](const Phase& phase) {
+        return phase.name == name;
+    });
+    if (it != m_phases.end())
+        return *it;
+
+    return m_phases.emplace_back(Phase{std::string(name)});
+}
+
+void CompileReport::merge(const CompileReport& other) {
+    for (const auto& otherPhase : other.m_phases) {
+        Phase& phase = this->phase(otherPhase.name);
+        phase.count += otherPhase.count;
+        phase.wall += otherPhase.wall;
+        phase.cpu += otherPhase.cpu;
+        phase.allocations += otherPhase.allocations;
+        phase.allocatedBytes += otherPhase.allocatedBytes;
+        phase.peakRssKb = std::max(phase.peakRssKb, otherPhase.peakRssKb);
+    }
+
+    m_functions.insert(m_functions.end(), other.m_functions.begin(), other.m_functions.end());
+}
+
+void CompileReport::printTimes(std::ostream& out, size_t slowestFunctions) const {
+    std::chrono::nanoseconds totalWall{0};
+    std::chrono::nanoseconds totalCpu{0};
+    for (const auto& phase : m_phases) {
+        totalWall += phase.wall;
+        totalCpu += phase.cpu;
+    }
+
+    out << std::fixed << std::setprecision(3);
+    out << "Time report (" << m_functions.size() << " functions)\n";
+    out << std::left << std::setw(24) << "phase" << std::right << std::setw(8) << "count" << std::setw(14)
+        << "wall (ms)" << std::setw(8) << "%" << std::setw(14) << "cpu (ms)" << "\n";
+    for (const auto& phase : m_phases) {
+        double percent = totalWall.count() ? 100.0 * phase.wall.count() / totalWall.count() : 0;
+        out << std::left << std::setw(24) << phase.name << std::right << std::setw(8) << phase.count
+            << std::setw(14) << milliseconds(phase.wall) << std::setprecision(1) << std::setw(8) << percent
+            << std::setprecision(3) << std::setw(14) << milliseconds(phase.cpu) << "\n";
+    }
+    out << std::left << std::setw(32) << "total" << std::right << std::setw(14) << milliseconds(totalWall)
+        << std::setw(8) << "" << std::setw(14) << milliseconds(totalCpu) << "\n";
+
+    if (slowestFunctions == 0 || m_functions.empty())
+        return;
+
+    std::vector<const FunctionTime*> functions;
+    for (const auto& function : m_functions) {
+        functions.push_back(&function);
+    }
+    size_t count = std::min(slowestFunctions, functions.size());
+    std::partial_sort(functions.begin(), functions.begin() + count, functions.end(), [](auto* a, auto* b) {
+        return a->wall > b->wall;
+    });
+
+    out << "\nSlowest functions (optimization and code generation)\n";
+    for (size_t i = 0; i < count; i++) {
+        out << std::left << std::setw(32) << functions[i]->name << std::right << std::setw(14)
+            << milliseconds(functions[i]->wall) << "\n";
+    }
+}
+
+void CompileReport::printMemory(std::ostream& out) const {
+    out << "Memory report (peak RSS " << peakRssKb() << " KiB)\n";
+    out << std::left << std::setw(24) << "phase" << std::right << std::setw(14) << "allocations" << std::setw(18)
+        << "bytes allocated" << std::setw(18) << "peak RSS (KiB)" << "\n";
+    for (const auto& phase : m_phases) {
+        out << std::left << std::setw(24) << phase.name << std::right << std::setw(14) << phase.allocations
+            << std::setw(18) << phase.allocatedBytes << std::setw(18) << phase.peakRssKb << "\n";
+    }
+}
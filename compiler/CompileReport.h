@@ -0,0 +1,81 @@
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// Time and memory spent in each phase of the compiler, printed by -ftime-report and -fmem-report.
+// A report is only used by one thread at a time, parallel compilations fill one report per function
+// and merge them afterwards.
+class CompileReport {
+  public:
+    struct Phase {
+        std::string name;
+        // Number of times the phase ran (passes run once per iteration of the pass manager)
+        size_t count = 0;
+        std::chrono::nanoseconds wall{0};
+        std::chrono::nanoseconds cpu{0};
+        size_t allocations = 0;
+        size_t allocatedBytes = 0;
+        // Highest peak RSS observed at the end of the phase
+        size_t peakRssKb = 0;
+    };
+
+    struct FunctionTime {
+        std::string name;
+        std::chrono::nanoseconds wall;
+    };
+
+    // Measure the phase from construction to destruction. A null report measures nothing
+    class Scope {
+      public:
+        Scope(CompileReport* report, std::string_view phase);
+        Scope(const Scope&) = delete;
+        Scope& operator=(const Scope&) = delete;
+        ~Scope();
+
+      private:
+        CompileReport* m_report;
+        std::string_view m_phase;
+        std::chrono::steady_clock::time_point m_wallStart;
+        std::chrono::nanoseconds m_cpuStart;
+        size_t m_allocationsStart;
+        size_t m_allocatedBytesStart;
+    };
+
+    void addFunction(std::string_view name, std::chrono::nanoseconds wall) {
+        m_functions.push_back({std::string(name), wall});
+    }
+
+    // Add the phases and functions of other to this report
+    void merge(const CompileReport& other);
+
+    // Print the time of every phase and the slowest functions
+    void printTimes(std::ostream& out, size_t slowestFunctions) const;
+    void printMemory(std::ostream& out) const;
+
+  private:
+    // Phases in order of first appearance
+    std::vector<Phase> m_phases;
+    std::vector<FunctionTime> m_functions;
+
+    Phase& phase(std::string_view name);
+};
+
+// CPU time consumed by the calling thread
+std::chrono::nanoseconds threadCpuTime();
+
+// Start counting the calls to operator new, for -fmem-report. Nothing is counted before, the counts of a phase
+// which started earlier are wrong
+void countAllocations();
+
+// Number of calls to operator new made by the calling thread since countAllocations, and the bytes they requested
+size_t threadAllocationCount();
+size_t threadAllocatedBytes();
+
+// Peak resident set size of the process in KiB
+size_t peakRssKb();
@@ -0,0 +1,212 @@
+#include "CompileServer.h"
+
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+#include <exception>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/time.h>
+#include <sys/un.h>
+#include <thread>
+#include <unistd.h>
+
+namespace {
+    // Limits of a request. The lengths come from the client, a malformed request is rejected instead of allocating
+    // what it claims
+    constexpr uint32_t MAX_ARGS = 1024;
+    constexpr uint64_t MAX_ARG_SIZE = 4096;
+    constexpr uint64_t MAX_SOURCE_SIZE = uint64_t(1) << 30;
+
+    // A client which stops sending or reading gives its thread back after this delay
+    constexpr time_t CONNECTION_TIMEOUT_SECONDS = 30;
+
+    // Closes the socket when it goes out of scope
+    class Socket {
+      public:
+        explicit Socket(int fd) : m_fd(fd) {}
+        Socket(const Socket&) = delete;
+        Socket& operator=(const Socket&) = delete;
+        ~Socket() {
+            if (m_fd >= 0)
+                close(m_fd);
+        }
+
+        int fd() const { return m_fd; }
+
+      private:
+        int m_fd;
+    };
+
+    bool socketAddress(const std::string& path, sockaddr_un& address, std::ostream& log) {
+        address = {};
+        address.sun_family = AF_UNIX;
+        if (path.size() >= sizeof(address.sun_path)) {
+            log << "error: socket path too long: " << path << std::endl;
+            return false;
+        }
+        std::memcpy(address.sun_path, path.c_str(), path.size() + 1);
+        return true;
+    }
+
+    bool writeAll(int fd, const void* data, size_t size) {
+        const char* bytes = static_cast<const char*>(data);
+        while (size > 0) {
+            // A client which went away must not kill the server with SIGPIPE
+            ssize_t count = send(fd, bytes, size, MSG_NOSIGNAL);
+            if (count < 0) {
+                if (errno == EINTR)
+                    continue;
+                return false;
+            }
+            bytes += count;
+            size -= count;
+        }
+        return true;
+    }
+
+    bool readAll(int fd, void* data, size_t size) {
+        char* bytes = static_cast<char*>(data);
+        while (size > 0) {
+            ssize_t count = read(fd, bytes, size);
+            if (count < 0 && errno == EINTR)
+                continue;
+            if (count <= 0)
+                return false;
+            bytes += count;
+            size -= count;
+        }
+        return true;
+    }
+
+    template <class T>
+    bool writeValue(int fd, T value) {
+        return writeAll(fd, &value, sizeof(value));
+    }
+
+    template <class T>
+    bool readValue(int fd, T& value) {
+        return readAll(fd, &value, sizeof(value));
+    }
+
+    bool writeString(int fd, const std::string& text) {
+        return writeValue<uint64_t>(fd, text.size()) && writeAll(fd, text.data(), text.size());
+    }
+
+    bool readString(int fd, std::string& text, uint64_t maxSize) {
+        uint64_t size;
+        if (!readValue(fd, size) || size > maxSize)
+            return false;
+        text.resize(size);
+        return readAll(fd, text.data(), size);
+    }
+
+    bool readRequest(int fd, CompileRequest& request) {
+        uint32_t argCount;
+        if (!readValue(fd, argCount) || argCount > MAX_ARGS)
+            return false;
+        request.args.resize(argCount);
+        for (auto& arg : request.args) {
+            if (!readString(fd, arg, MAX_ARG_SIZE))
+                return false;
+        }
+        return readString(fd, request.name, MAX_ARG_SIZE) && readString(fd, request.source, MAX_SOURCE_SIZE);
+    }
+
+    void serve(int fd, const CompileHandler& handler, std::ostream& log) {
+        Socket connection(fd);
+        // An exception must not leave the thread, it would terminate the server with every other request
+        try {
+            timeval timeout{CONNECTION_TIMEOUT_SECONDS, 0};
+            setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+            setsockopt(fd, SOL_SOCKET, SO_SNDTIMEO, &timeout, sizeof(timeout));
+
+            CompileRequest request;
+            if (!readRequest(fd, request)) {
+                return;
+            }
+
+            // Nobody is left to tell if the client went away before the response
+            CompileResponse response = handler(request);
+            writeValue<int32_t>(fd, response.status) && writeString(fd, response.assembly) &&
+                writeString(fd, response.diagnostics);
+        } catch (const std::exception& error) {
+            log << "error: request dropped: " << error.what() << std::endl;
+        }
+    }
+}
+
+void runServer(const std::string& path, const CompileHandler& handler, std::ostream& log) {
+    sockaddr_un address;
+    if (!socketAddress(path, address, log)) {
+        return;
+    }
+
+    Socket listener(socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0));
+    if (listener.fd() < 0) {
+        log << "error: cannot create socket: " << std::strerror(errno) << std::endl;
+        return;
+    }
+
+    // The socket file of a killed server stays behind. It is only replaced when no server answers on it
+    struct stat info;
+    if (stat(path.c_str(), &info) == 0 && S_ISSOCK(info.st_mode)) {
+        Socket probe(socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0));
+        if (connect(probe.fd(), reinterpret_cast<sockaddr*>(&address), sizeof(address)) == 0) {
+            log << "error: a server is already listening on " << path << std::endl;
+            return;
+        }
+        unlink(path.c_str());
+    }
+
+    if (bind(listener.fd(), reinterpret_cast<sockaddr*>(&address), sizeof(address)) < 0 ||
+        listen(listener.fd(), SOMAXCONN) < 0) {
+        log << "error: cannot listen on " << path << ": " << std::strerror(errno) << std::endl;
+        return;
+    }
+
+    while (true) {
+        int fd = accept4(listener.fd(), nullptr, nullptr, SOCK_CLOEXEC);
+        if (fd < 0) {
+            if (errno == EINTR || errno == ECONNABORTED)
+                continue;
+            log << "error: cannot accept a connection: " << std::strerror(errno) << std::endl;
+            return;
+        }
+
+        // Requests are independent, a long compilation does not delay the others
+        std::thread(serve, fd, std::cref(handler), std::ref(log)).detach();
+    }
+}
+
+std::optional<CompileResponse> sendRequest(const std::string& path, const CompileRequest& request, std::ostream& log) {
+    sockaddr_un address;
+    if (!socketAddress(path, address, log)) {
+        return std::nullopt;
+    }
+
+    Socket connection(socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0));
+    if (connection.fd() < 0 || connect(connection.fd(), reinterpret_cast<sockaddr*>(&address), sizeof(address)) < 0) {
+        log << "error: cannot connect to the server on " << path << ": " << std::strerror(errno) << std::endl;
+        return std::nullopt;
+    }
+
+    int fd = connection.fd();
+    bool sent = writeValue<uint32_t>(fd, request.args.size());
+    for (const auto& arg : request.args) {
+        sent = sent && writeString(fd, arg);
+    }
+    sent = sent && writeString(fd, request.name) && writeString(fd, request.source);
+
+    CompileResponse response;
+    int32_t status;
+    // The response comes from the server, its size is not limited
+    uint64_t maxSize = response.assembly.max_size();
+    if (!sent || !readValue(fd, status) || !readString(fd, response.assembly, maxSize) ||
+        !readString(fd, response.diagnostics, maxSize)) {
+        log << "error: the server on " << path << " closed the connection" << std::endl;
+        return std::nullopt;
+    }
+    response.status = status;
+    return response;
+}
@@ -0,0 +1,42 @@
+#pragma once
+
+#include <functional>
+#include <optional>
+#include <ostream>
+#include <string>
+#include <vector>
+
+// Compile server of `ifcc --server path.sock`, and the client of `ifcc --client path.sock`.
+//
+// The process of the server stays alive between compilations, so the ATN and the DFA cache of the
+// parser are built once and stay warm. Each connection carries one request and its response, and each
+// connection is handled on its own thread, which gives up after 30 s without progress from the client. A request
+// with more than 1024 arguments, an argument or a name longer than 4 KiB or a file larger than 1 GiB is dropped.
+// Strings are sent as their uint64 length followed by their bytes, integers in the byte order of the machine
+// since both sides run on it:
+//
+//     request:  uint32 argument count, the arguments, the name of the file, its content
+//     response: int32 exit status, the assembly, the diagnostics
+
+struct CompileRequest {
+    // Options of the command line of the client, without the input files and the outputs
+    std::vector<std::string> args;
+    std::string name;
+    std::string source;
+};
+
+struct CompileResponse {
+    int status = 0;
+    std::string assembly;
+    std::string diagnostics;
+};
+
+using CompileHandler = std::function<CompileResponse(const CompileRequest&)>;
+
+// Answer the requests sent to the Unix socket at path with handler. A stale socket left by a server which
+// was killed is replaced. Only return when the socket cannot be listened to, after printing why to log
+void runServer(const std::string& path, const CompileHandler& handler, std::ostream& log);
+
+// Send request to the server listening at path and wait for its response. Return nullopt after printing why
+// to log if the server cannot be reached
+std::optional<CompileResponse> sendRequest(const std::string& path, const CompileRequest& request, std::ostream& log);
@@ -5,6 +5,7 @@
 
 using namespace ir;
 void ConstantFoldingVisitor::visit(ir::BasicBlock& block) {
+    m_currentBlock = &block;
 
     for (auto& instr : block.instructions()) {
         m_currentInstruction = &instr;
@@ -12,7 +13,6 @@ void ConstantFoldingVisitor::visit(ir::BasicBlock& block) {
     }
 
     if (block.terminator()) {
-        m_currentTerminator = &block.terminator();
         visitBase(*block.terminator());
     }
 }
@@ -52,6 +52,7 @@ void ConstantFoldingVisitor::visit(ir::BinaryOp& binaryOp) {
             case BinaryOpKind::BIT_AND: return Immediate(left & right, type);
             case BinaryOpKind::BIT_XOR: return Immediate(left ^ right, type);
             case BinaryOpKind::BIT_OR: return Immediate(left | right, type);
+            case BinaryOpKind::SHL: return Immediate(left << right, type);
             default: throw std::runtime_error("Unhandled binary op");
         }
     };
@@ -66,7 +67,7 @@ void ConstantFoldingVisitor::visit(ir::BinaryOp& binaryOp) {
         }
     }();
 
-    *m_currentInstruction = std::make_unique<Assignment>(binaryOp.destination(), folded);
+    *m_currentInstruction = m_currentBlock->allocate<Assignment>(binaryOp.destination(), folded);
     m_changed = true;
 }
 
@@ -89,40 +90,40 @@ bool ConstantFoldingVisitor::tryFoldSpecialBinaryOp(ir::BinaryOp& binaryOp) {
     switch (binaryOp.operation()) {
         case BinaryOpKind::ADD:
             if (isImmediateEqual(binaryOp.right(), 0)) {
-                *m_currentInstruction = std::make_unique<Assignment>(binaryOp.destination(), binaryOp.left());
+                *m_currentInstruction = m_currentBlock->allocate<Assignment>(binaryOp.destination(), binaryOp.left());
                 return true;
             }
             if (isImmediateEqual(binaryOp.left(), 0)) {
-                *m_currentInstruction = std::make_unique<Assignment>(binaryOp.destination(), binaryOp.right());
+                *m_currentInstruction = m_currentBlock->allocate<Assignment>(binaryOp.destination(), binaryOp.right());
                 return true;
             }
             break;
         case BinaryOpKind::SUB:
             if (isImmediateEqual(binaryOp.right(), 0)) {
-                *m_currentInstruction = std::make_unique<Assignment>(binaryOp.destination(), binaryOp.left());
+                *m_currentInstruction = m_currentBlock->allocate<Assignment>(binaryOp.destination(), binaryOp.left());
                 return true;
             }
             if (isImmediateEqual(binaryOp.left(), 0)) {
                 *m_currentInstruction =
-                    std::make_unique<UnaryOp>(binaryOp.destination(), binaryOp.right(), UnaryOpKind::MINUS);
+                    m_currentBlock->allocate<UnaryOp>(binaryOp.destination(), binaryOp.right(), UnaryOpKind::MINUS);
                 return true;
             }
             break;
         case BinaryOpKind::MUL:
             if (isImmediateEqual(binaryOp.right(), 0)) {
-                *m_currentInstruction = std::make_unique<Assignment>(binaryOp.destination(), binaryOp.right());
+                *m_currentInstruction = m_currentBlock->allocate<Assignment>(binaryOp.destination(), binaryOp.right());
                 return true;
             }
             if (isImmediateEqual(binaryOp.left(), 0)) {
-                *m_currentInstruction = std::make_unique<Assignment>(binaryOp.destination(), binaryOp.left());
+                *m_currentInstruction = m_currentBlock->allocate<Assignment>(binaryOp.destination(), binaryOp.left());
                 return true;
             }
             if (isImmediateEqual(binaryOp.right(), 1)) {
-                *m_currentInstruction = std::make_unique<Assignment>(binaryOp.destination(), binaryOp.left());
+                *m_currentInstruction = m_currentBlock->allocate<Assignment>(binaryOp.destination(), binaryOp.left());
                 return true;
             }
             if (isImmediateEqual(binaryOp.left(), 1)) {
-                *m_currentInstruction = std::make_unique<Assignment>(binaryOp.destination(), binaryOp.right());
+                *m_currentInstruction = m_currentBlock->allocate<Assignment>(binaryOp.destination(), binaryOp.right());
                 return true;
             }
             break;
@@ -159,7 +160,7 @@ void ConstantFoldingVisitor::visit(ir::UnaryOp& unaryOp) {
         }
     }();
 
-    *m_currentInstruction = std::make_unique<Assignment>(unaryOp.destination(), folded);
+    *m_currentInstruction = m_currentBlock->allocate<Assignment>(unaryOp.destination(), folded);
     m_changed = true;
 }
 
@@ -169,7 +170,7 @@ void ConstantFoldingVisitor::visit(ir::Cast& cast) {
 
     // Source and dest types have the same bit representation so we can just assign
     if (sourceType->size() == destType->size()) {
-        *m_currentInstruction = std::make_unique<Assignment>(cast.destination(), cast.source());
+        *m_currentInstruction = m_currentBlock->allocate<Assignment>(cast.destination(), cast.source());
         return;
     }
 
@@ -190,7 +191,7 @@ void ConstantFoldingVisitor::visit(ir::Cast& cast) {
         }
     }();
 
-    *m_currentInstruction = std::make_unique<Assignment>(cast.destination(), folded);
+    *m_currentInstruction = m_currentBlock->allocate<Assignment>(cast.destination(), folded);
     m_changed = true;
 }
 
@@ -210,6 +211,6 @@ void ConstantFoldingVisitor::visit(ir::ConditionalJump& jump) {
     }
     BasicBlock* target = b ? jump.trueTarget() : jump.falseTarget();
 
-    *m_currentTerminator = std::make_unique<BasicJump>(target);
+    m_currentBlock->terminate<BasicJump>(target);
     m_changed = true;
 }
@@ -17,7 +17,7 @@ class ConstantFoldingVisitor : public ir::Visitor {
     bool changed() const { return m_changed; }
 
   private:
-    std::unique_ptr<ir::Instruction>* m_currentInstruction;
-    std::unique_ptr<ir::Terminator>* m_currentTerminator;
+    ir::BasicBlock* m_currentBlock;
+    ir::Instruction** m_currentInstruction;
     bool m_changed = false;
 };
@@ -28,8 +28,8 @@ class DeadCodeElimination : public ir::Visitor {
     bool changed() const { return m_changed; }
 
   private:
-    std::unordered_set<ir::Local> m_workingSet;
-    std::unique_ptr<ir::Instruction>* m_currentInstruction;
+    LiveSet m_workingSet;
+    ir::Instruction** m_currentInstruction;
     BlockLivenessAnalysis& m_blocksLivenessAnalysis;
     PointedLocals& m_pointedLocals;
     bool m_changed = false;
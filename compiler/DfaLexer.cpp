@@ -0,0 +1,266 @@
+#include "DfaLexer.h"
+
+#include <iostream>
+#include <stdexcept>
+#include <string>
+
+using namespace antlr4;
+
+namespace {
+    enum CharClass : uint8_t { OTHER, LETTER, DIGIT, SPACE };
+
+    constexpr std::array<CharClass, 256> CHAR_CLASSES = []() {
+        std::array<CharClass, 256> classes{};
+        for (int c = 'a'; c <= 'z'; c++)
+            classes[c] = LETTER;
+        for (int c = 'A'; c <= 'Z'; c++)
+            classes[c] = LETTER;
+        for (int c = '0'; c <= '9'; c++)
+            classes[c] = DIGIT;
+        for (int c : {' ', '\t', '\r', '\n'})
+            classes[c] = SPACE;
+        return classes;
+    }();
+
+    CharClass charClass(char c) { return CHAR_CLASSES[static_cast<unsigned char>(c)]; }
+
+    struct Spelling {
+        std::string_view text;
+        // Symbolic name of the token, or literal name for the tokens implicitly defined in the parser rules
+        std::string_view token;
+    };
+
+    // Two characters operators come first so they win over their prefix
+    constexpr Spelling OPERATORS[] = {
+        {"++", "INCRDECR_OP"}, {"--", "INCRDECR_OP"}, {"+=", "ASSIGN_OP"},  {"-=", "ASSIGN_OP"},
+        {"*=", "ASSIGN_OP"},   {"/=", "ASSIGN_OP"},   {"%=", "ASSIGN_OP"},  {"&=", "ASSIGN_OP"},
+        {"^=", "ASSIGN_OP"},   {"|=", "ASSIGN_OP"},   {"&&", "LOGICAL_AND"}, {"||", "LOGICAL_OR"},
+        {">=", "CMP_OP"},      {"<=", "CMP_OP"},      {"==", "EQ_OP"},      {"!=", "EQ_OP"},
+        {"+", "SUM_OP"},       {"-", "SUM_OP"},       {"*", "STAR"},        {"/", "PRODUCT_OP"},
+        {"%", "PRODUCT_OP"},   {"!", "UNARY_OP"},     {">", "CMP_OP"},      {"<", "CMP_OP"},
+        {"&", "BIT_AND"},      {"^", "BIT_XOR"},      {"|", "BIT_OR"},      {"(", "'('"},
+        {")", "')'"},          {",", "','"},          {";", "';'"},         {"{", "'{'"},
+        {"}", "'}'"},          {"=", "'='"},          {"[", "'['"},         {"]", "']'"},
+    };
+
+    constexpr Spelling KEYWORDS[] = {
+        {"return", "RETURN"}, {"int", "FLAT_TYPE"},   {"void", "FLAT_TYPE"},     {"char", "FLAT_TYPE"},
+        {"short", "FLAT_TYPE"}, {"long", "FLAT_TYPE"}, {"bool", "FLAT_TYPE"},    {"if", "IF"},
+        {"while", "WHILE"},   {"else", "ELSE"},       {"break", "BREAK"},        {"continue", "CONTINUE"},
+    };
+
+    // Same display as antlr4::Lexer::getErrorDisplay
+    std::string errorDisplay(std::string_view text) {
+        std::string display;
+        for (char c : text) {
+            switch (c) {
+                case '\n': display += "\\n"; break;
+                case '\t': display += "\\t"; break;
+                case '\r': display += "\\r"; break;
+                default: display += c; break;
+            }
+        }
+        return display;
+    }
+}
+
+DfaLexer::DfaLexer(SourceCharStream& input, const dfa::Vocabulary& vocabulary, std::ostream& log) :
+    m_input(input), m_text(input.text()), m_log(log) {
+    auto tokenType = [&](std::string_view name) {
+        for (size_t type = 1; type <= vocabulary.getMaxTokenType(); type++) {
+            if (vocabulary.getSymbolicName(type) == name || vocabulary.getLiteralName(type) == name) {
+                return type;
+            }
+        }
+        throw std::runtime_error("Token " + std::string(name) + " is not in the grammar");
+    };
+
+    for (const auto& spelling : OPERATORS) {
+        m_operators[spelling.text[0]].emplace_back(spelling.text, tokenType(spelling.token));
+    }
+    for (const auto& spelling : KEYWORDS) {
+        m_keywords.emplace_back(spelling.text, tokenType(spelling.token));
+    }
+
+    m_ident = tokenType("IDENT");
+    m_const = tokenType("CONST");
+    m_char = tokenType("CHAR");
+    m_string = tokenType("STRING");
+    m_ws = tokenType("WS");
+}
+
+std::unique_ptr<Token> DfaLexer::nextToken() {
+    while (m_position < m_text.size()) {
+        size_t start = m_position;
+        size_t line = m_line;
+        size_t column = m_column;
+
+        Match match = this->match(start);
+        if (match.kind == Match::ERROR) {
+            // Like ANTLR, report everything up to the character which failed and skip it
+            size_t end = std::min(match.end + 1, m_text.size());
+            m_log << "line " << line << ":" << column << " token recognition error at: '"
+                  << errorDisplay(m_text.substr(start, end - start)) << "'" << std::endl;
+            advance(end);
+            continue;
+        }
+
+        advance(match.end);
+        if (match.kind == Match::SKIP) {
+            continue;
+        }
+
+        // The text is read back from the input when needed
+        size_t channel = match.type == m_ws ? Token::HIDDEN_CHANNEL : Token::DEFAULT_CHANNEL;
+        return getTokenFactory()->create(
+            {this, &m_input}, match.type, "", channel, start, match.end - 1, line, column
+        );
+    }
+
+    return getTokenFactory()->create(
+        {this, &m_input}, Token::EOF, "", Token::DEFAULT_CHANNEL, m_position, m_position - 1, m_line, m_column
+    );
+}
+
+void DfaLexer::advance(size_t end) {
+    for (; m_position < end; m_position++) {
+        if (m_text[m_position] == '\n') {
+            m_line++;
+            m_column = 0;
+        } else {
+            m_column++;
+        }
+    }
+}
+
+DfaLexer::Match DfaLexer::match(size_t start) const {
+    char c = m_text[start];
+    switch (charClass(c)) {
+        case SPACE: return {Match::TOKEN, m_ws, start + 1};
+        case LETTER: return matchWord(start);
+        case DIGIT: {
+            size_t end = start + 1;
+            while (end < m_text.size() && charClass(m_text[end]) == DIGIT)
+                end++;
+            return {Match::TOKEN, m_const, end};
+        }
+        case OTHER: break;
+    }
+
+    switch (c) {
+        case '\'': return matchChar(start);
+        case '"': return matchString(start);
+        case '#': {
+            // DIRECTIVE : '#' .*? '\n'
+            size_t newline = m_text.find('\n', start + 1);
+            if (newline == std::string_view::npos)
+                return {Match::ERROR, 0, m_text.size()};
+            return {Match::SKIP, 0, newline + 1};
+        }
+        case '/':
+            // COMMENT : '/*' .*? '*/', an unterminated comment is a division followed by a star
+            if (start + 1 < m_text.size() && m_text[start + 1] == '*') {
+                size_t close = m_text.find("*/", start + 2);
+                if (close != std::string_view::npos)
+                    return {Match::SKIP, 0, close + 2};
+            }
+            break;
+    }
+
+    if (static_cast<unsigned char>(c) < m_operators.size()) {
+        for (const auto& [spelling, type] : m_operators[c]) {
+            if (m_text.substr(start).starts_with(spelling)) {
+                return {Match::TOKEN, type, start + spelling.size()};
+            }
+        }
+    }
+
+    return {Match::ERROR, 0, start};
+}
+
+DfaLexer::Match DfaLexer::matchWord(size_t start) const {
+    size_t end = start + 1;
+    while (end < m_text.size() && (charClass(m_text[end]) == LETTER || charClass(m_text[end]) == DIGIT))
+        end++;
+
+    // Keywords are defined before IDENT in the grammar so they win on a match of the same length
+    std::string_view word = m_text.substr(start, end - start);
+    for (const auto& [keyword, type] : m_keywords) {
+        if (word == keyword) {
+            return {Match::TOKEN, type, end};
+        }
+    }
+
+    return {Match::TOKEN, m_ident, end};
+}
+
+DfaLexer::Match DfaLexer::matchChar(size_t start) const {
+    // CHAR : '\'' (~[\\'] | ('\\' + ('n' | 't' | 'r' | '0' | '\'' | '\\'))) '\''
+    auto at = [&](size_t i) { return i < m_text.size() ? m_text[i] : '\0'; };
+    auto isQuote = [&](size_t i) { return i < m_text.size() && m_text[i] == '\''; };
+
+    size_t i = start + 1;
+    if (i >= m_text.size() || m_text[i] == '\'')
+        return {Match::ERROR, 0, i};
+
+    if (m_text[i] != '\\') {
+        if (isQuote(i + 1))
+            return {Match::TOKEN, m_char, i + 2};
+        return {Match::ERROR, 0, i + 1};
+    }
+
+    size_t runEnd = i;
+    while (runEnd < m_text.size() && m_text[runEnd] == '\\')
+        runEnd++;
+    // With at least two backslashes the last one can be the escaped character
+    bool lastBackslashEscaped = runEnd - i >= 2;
+
+    char c = at(runEnd);
+    if (runEnd < m_text.size() && (c == 'n' || c == 't' || c == 'r' || c == '0' || c == '\'')) {
+        if (isQuote(runEnd + 1))
+            return {Match::TOKEN, m_char, runEnd + 2};
+        // The quote after the backslashes was the closing one
+        if (c == '\'' && lastBackslashEscaped)
+            return {Match::TOKEN, m_char, runEnd + 1};
+        return {Match::ERROR, 0, runEnd + 1};
+    }
+
+    return {Match::ERROR, 0, runEnd};
+}
+
+DfaLexer::Match DfaLexer::matchString(size_t start) const {
+    // STRING : '"' ((~[\\"] | ('\\' + ('n' | 't' | 'r' | '0' | '"' | '\\')))*?) '"'
+    // States of the DFA ANTLR builds for the rule. The loop is not greedy so a quote ends the string
+    // as soon as it can, except after two backslashes or more where the quote can also be escaped:
+    // ANTLR then remembers the string ending there but keeps going and takes the next quote if it
+    // reaches one.
+    enum { INSIDE, BACKSLASH, BACKSLASHES } state = INSIDE;
+    size_t lastAccept = std::string_view::npos;
+
+    size_t i = start + 1;
+    for (; i < m_text.size(); i++) {
+        char c = m_text[i];
+        if (state == INSIDE) {
+            if (c == '"')
+                return {Match::TOKEN, m_string, i + 1};
+            state = c == '\\' ? BACKSLASH : INSIDE;
+        } else if (state == BACKSLASH) {
+            if (c == '\\') {
+                state = BACKSLASHES;
+            } else if (c == 'n' || c == 't' || c == 'r' || c == '0' || c == '"') {
+                state = INSIDE;
+            } else {
+                break;
+            }
+        } else {
+            if (c == '"') {
+                lastAccept = i + 1;
+            }
+            state = c == '\\' ? BACKSLASHES : INSIDE;
+        }
+    }
+
+    if (lastAccept != std::string_view::npos)
+        return {Match::TOKEN, m_string, lastAccept};
+    return {Match::ERROR, 0, i};
+}
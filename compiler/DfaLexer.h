@@ -0,0 +1,61 @@
+#pragma once
+
+#include "SourceFile.h"
+#include "antlr4-runtime.h"
+#include <array>
+#include <iostream>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+// Hand-written lexer producing the same tokens as the ifccLexer generated by ANTLR, enabled with -fdfa-lexer.
+// The token types are looked up by name in the vocabulary of the grammar so it stays in sync with ifcc.g4.
+//
+// Like ANTLR, it takes the longest match (keywords win over identifiers of the same length), stops strings and
+// comments at the first possible end, emits whitespaces on the hidden channel, and reports characters it
+// cannot match as token recognition errors before skipping them.
+class DfaLexer : public antlr4::TokenSource {
+  public:
+    // Token recognition errors are printed to log
+    DfaLexer(SourceCharStream& input, const antlr4::dfa::Vocabulary& vocabulary, std::ostream& log = std::cerr);
+
+    std::unique_ptr<antlr4::Token> nextToken() override;
+
+    size_t getLine() const override { return m_line; }
+    size_t getCharPositionInLine() override { return m_column; }
+    antlr4::CharStream* getInputStream() override { return &m_input; }
+    std::string getSourceName() override { return m_input.getSourceName(); }
+    antlr4::TokenFactory<antlr4::CommonToken>* getTokenFactory() override {
+        return antlr4::CommonTokenFactory::DEFAULT.get();
+    }
+
+  private:
+    // Result of matching the text at the current position
+    struct Match {
+        enum Kind { TOKEN, SKIP, ERROR } kind;
+        size_t type;
+        // End of the token, or index of the character where no rule can continue for an ERROR
+        size_t end;
+    };
+
+    SourceCharStream& m_input;
+    std::string_view m_text;
+    std::ostream& m_log;
+    size_t m_position = 0;
+    size_t m_line = 1;
+    size_t m_column = 0;
+
+    // Operators and punctuation starting with each character, longest first
+    std::array<std::vector<std::pair<std::string_view, size_t>>, 128> m_operators;
+    std::vector<std::pair<std::string_view, size_t>> m_keywords;
+
+    size_t m_ident, m_const, m_char, m_string, m_ws;
+
+    Match match(size_t start) const;
+    Match matchWord(size_t start) const;
+    Match matchChar(size_t start) const;
+    Match matchString(size_t start) const;
+
+    // Move to end, updating the line and the column
+    void advance(size_t end);
+};
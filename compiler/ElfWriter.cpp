@@ -0,0 +1,187 @@
+#include "ElfWriter.h"
+
+#include <array>
+#include <cstring>
+#include <elf.h>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+
+namespace {
+    // Section indexes of the object
+    enum : uint16_t { TEXT = 1, RELA_TEXT, RODATA, NOTE_GNU_STACK, SYMTAB, STRTAB, SHSTRTAB, SECTION_COUNT };
+
+    constexpr const char* SECTION_NAMES[SECTION_COUNT] = {
+        "", ".text", ".rela.text", ".rodata", ".note.GNU-stack", ".symtab", ".strtab", ".shstrtab",
+    };
+
+    // Symbols of .text and .rodata come after the null symbol, the global symbols follow them
+    constexpr uint32_t RODATA_SYMBOL = 2;
+    constexpr uint32_t FIRST_GLOBAL_SYMBOL = 3;
+
+    // The structures are written in the byte order of the machine, ifcc only runs on x86-64
+    template <class T>
+    void append(std::string& out, const T& value) {
+        out.append(reinterpret_cast<const char*>(&value), sizeof(T));
+    }
+
+    void align(std::string& out, size_t alignment) { out.resize((out.size() + alignment - 1) / alignment * alignment); }
+}
+
+std::string decodeLiteral(std::string_view text) {
+    std::string bytes;
+    for (size_t i = 0; i < text.size(); i++) {
+        if (text[i] != '\\' || i + 1 == text.size()) {
+            bytes.push_back(text[i]);
+            continue;
+        }
+
+        char c = text[++i];
+        switch (c) {
+            case 'b': bytes.push_back('\b'); break;
+            case 'f': bytes.push_back('\f'); break;
+            case 'n': bytes.push_back('\n'); break;
+            case 'r': bytes.push_back('\r'); break;
+            case 't': bytes.push_back('\t'); break;
+            default:
+                if (c >= '0' && c <= '7') {
+                    // Up to 3 octal digits
+                    int value = c - '0';
+                    for (int digits = 1; digits < 3 && i + 1 < text.size() && text[i + 1] >= '0' && text[i + 1] <= '7';
+                         digits++) {
+                        value = value * 8 + (text[++i] - '0');
+                    }
+                    bytes.push_back(char(value));
+                } else {
+                    // \\, \" and the escapes the assembler does not know stand for the character itself
+                    bytes.push_back(c);
+                }
+        }
+    }
+    return bytes;
+}
+
+void ElfWriter::addFunction(const MachineCode& code) {
+    uint32_t offset = m_text.size();
+    m_functions.push_back({code.function, offset, uint32_t(code.bytes.size())});
+    m_text.insert(m_text.end(), code.bytes.begin(), code.bytes.end());
+    for (CodeRelocation relocation : code.relocations) {
+        relocation.offset += offset;
+        m_relocations.push_back(relocation);
+    }
+}
+
+void ElfWriter::write(std::ostream& out, const StringInterner& literals) const {
+    std::string rodata;
+    std::vector<uint32_t> literalOffsets(literals.size());
+    for (Symbol i = 0; i < literals.size(); i++) {
+        literalOffsets[i] = rodata.size();
+        rodata += decodeLiteral(literals.text(i));
+        rodata.push_back('\0');
+    }
+
+    // The local symbols come before the global ones
+    std::string symtab;
+    std::string strtab(1, '\0');
+    append(symtab, Elf64_Sym{});
+    append(symtab, Elf64_Sym{0, ELF64_ST_INFO(STB_LOCAL, STT_SECTION), 0, TEXT, 0, 0});
+    append(symtab, Elf64_Sym{0, ELF64_ST_INFO(STB_LOCAL, STT_SECTION), 0, RODATA, 0, 0});
+
+    std::unordered_map<Symbol, uint32_t> symbolIndexes;
+    auto addSymbol = [&](Symbol name, unsigned char type, uint16_t section, uint64_t value, uint64_t size) {
+        symbolIndexes.emplace(name, symtab.size() / sizeof(Elf64_Sym));
+        uint32_t nameOffset = strtab.size();
+        strtab += globalSymbols.text(name);
+        strtab.push_back('\0');
+        auto info = static_cast<unsigned char>(ELF64_ST_INFO(STB_GLOBAL, type));
+        append(symtab, Elf64_Sym{nameOffset, info, 0, section, value, size});
+    };
+    for (const auto& function : m_functions) {
+        addSymbol(function.name, STT_FUNC, TEXT, function.offset, function.size);
+    }
+    // The functions called but not defined here are resolved by the linker
+    for (const auto& relocation : m_relocations) {
+        if (relocation.kind == CodeRelocation::Kind::CALL && !symbolIndexes.contains(relocation.target)) {
+            addSymbol(relocation.target, STT_NOTYPE, SHN_UNDEF, 0, 0);
+        }
+    }
+
+    std::string rela;
+    for (const auto& relocation : m_relocations) {
+        Elf64_Rela entry;
+        entry.r_offset = relocation.offset;
+        if (relocation.kind == CodeRelocation::Kind::CALL) {
+            entry.r_info = ELF64_R_INFO(symbolIndexes.at(relocation.target), R_X86_64_PLT32);
+            entry.r_addend = relocation.addend;
+        } else {
+            entry.r_info = ELF64_R_INFO(RODATA_SYMBOL, R_X86_64_PC32);
+            entry.r_addend = int64_t(literalOffsets.at(relocation.target)) + relocation.addend;
+        }
+        append(rela, entry);
+    }
+
+    std::string shstrtab;
+    std::array<uint32_t, SECTION_COUNT> nameOffsets;
+    for (size_t i = 0; i < SECTION_COUNT; i++) {
+        nameOffsets[i] = shstrtab.size();
+        shstrtab += SECTION_NAMES[i];
+        shstrtab.push_back('\0');
+    }
+
+    // The ELF header is filled last, once the section headers are placed after the sections
+    std::string file(sizeof(Elf64_Ehdr), '\0');
+    std::array<Elf64_Shdr, SECTION_COUNT> sections{};
+    auto section = [&](uint16_t index, uint32_t type, uint64_t flags, std::string_view data,
+                       uint64_t alignment) -> Elf64_Shdr& {
+        Elf64_Shdr& header = sections[index];
+        header.sh_name = nameOffsets[index];
+        header.sh_type = type;
+        header.sh_flags = flags;
+        header.sh_addralign = alignment;
+        align(file, alignment);
+        header.sh_offset = file.size();
+        header.sh_size = data.size();
+        file += data;
+        return header;
+    };
+
+    std::string_view text(reinterpret_cast<const char*>(m_text.data()), m_text.size());
+    section(TEXT, SHT_PROGBITS, SHF_ALLOC | SHF_EXECINSTR, text, 1);
+    Elf64_Shdr& relaHeader = section(RELA_TEXT, SHT_RELA, SHF_INFO_LINK, rela, 8);
+    relaHeader.sh_link = SYMTAB;
+    relaHeader.sh_info = TEXT;
+    relaHeader.sh_entsize = sizeof(Elf64_Rela);
+    section(RODATA, SHT_PROGBITS, SHF_ALLOC, rodata, 1);
+    // Without it the linker makes the stack executable
+    section(NOTE_GNU_STACK, SHT_PROGBITS, 0, "", 1);
+    Elf64_Shdr& symtabHeader = section(SYMTAB, SHT_SYMTAB, 0, symtab, 8);
+    symtabHeader.sh_link = STRTAB;
+    symtabHeader.sh_info = FIRST_GLOBAL_SYMBOL;
+    symtabHeader.sh_entsize = sizeof(Elf64_Sym);
+    section(STRTAB, SHT_STRTAB, 0, strtab, 1);
+    section(SHSTRTAB, SHT_STRTAB, 0, shstrtab, 1);
+
+    align(file, 8);
+    uint64_t sectionHeadersOffset = file.size();
+    for (const auto& header : sections) {
+        append(file, header);
+    }
+
+    Elf64_Ehdr header{};
+    std::memcpy(header.e_ident, ELFMAG, SELFMAG);
+    header.e_ident[EI_CLASS] = ELFCLASS64;
+    header.e_ident[EI_DATA] = ELFDATA2LSB;
+    header.e_ident[EI_VERSION] = EV_CURRENT;
+    header.e_ident[EI_OSABI] = ELFOSABI_SYSV;
+    header.e_type = ET_REL;
+    header.e_machine = EM_X86_64;
+    header.e_version = EV_CURRENT;
+    header.e_shoff = sectionHeadersOffset;
+    header.e_ehsize = sizeof(Elf64_Ehdr);
+    header.e_shentsize = sizeof(Elf64_Shdr);
+    header.e_shnum = SECTION_COUNT;
+    header.e_shstrndx = SHSTRTAB;
+    std::memcpy(file.data(), &header, sizeof(header));
+
+    out.write(file.data(), file.size());
+}
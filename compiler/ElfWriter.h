@@ -0,0 +1,35 @@
+#pragma once
+
+#include "StringInterner.h"
+#include "X86Encoder.h"
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// Bytes of a literal, read like the assembler reads the text between the quotes of .asciz
+std::string decodeLiteral(std::string_view text);
+
+// Relocatable ELF64 object of `ifcc -c`. The machine code of the functions is appended to .text in the order of
+// the output, and the whole object is written at once with the string literals of the translation unit in .rodata.
+// Every function is a global symbol. The called functions which are not defined in the file are undefined symbols
+// resolved by the linker, calls go through the PLT (R_X86_64_PLT32) and literals are rip relative (R_X86_64_PC32)
+class ElfWriter {
+  public:
+    void addFunction(const MachineCode& code);
+
+    void write(std::ostream& out, const StringInterner& literals) const;
+
+  private:
+    struct FunctionSymbol {
+        Symbol name;
+        uint32_t offset;
+        uint32_t size;
+    };
+
+    std::vector<uint8_t> m_text;
+    std::vector<FunctionSymbol> m_functions;
+    // Offsets from the start of .text
+    std::vector<CodeRelocation> m_relocations;
+};
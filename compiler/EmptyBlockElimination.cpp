@@ -23,10 +23,11 @@ void EmptyBlockEliminationVisitor::visit(BasicJump& jump) {
     BasicBlock* target = jump.target();
     if (target->terminator()) {
         if (target->instructions().empty() && m_dependanceMap[target].size() == 1) {
-            m_currentBlock->terminate(std::move(target->terminator()));
+            m_currentBlock->terminate(target->terminator());
             target->terminate<BasicJump>(target);
+            m_changed = true;
         } else {
-            BasicJump* nextJump = dynamic_cast<BasicJump*>(target->terminator().get());
+            BasicJump* nextJump = dynamic_cast<BasicJump*>(target->terminator());
             if (nextJump) {
                 if (target->instructions().empty()) {
                     jump.setTarget(nextJump->target());
@@ -54,13 +55,13 @@ void EmptyBlockEliminationVisitor::visit(ConditionalJump& jump) {
 
     BasicBlock* trueTarget = jump.trueTarget();
     if (trueTarget->instructions().empty() && trueTarget->terminator()) {
-        BasicJump* nextJump = dynamic_cast<BasicJump*>(trueTarget->terminator().get());
+        BasicJump* nextJump = dynamic_cast<BasicJump*>(trueTarget->terminator());
         if (nextJump) {
             jump.setTrueTarget(nextJump->target());
             setNeedSkip(trueTarget);
             m_changed = true;
         } else {
-            ConditionalJump* nextCondJump = dynamic_cast<ConditionalJump*>(trueTarget->terminator().get());
+            ConditionalJump* nextCondJump = dynamic_cast<ConditionalJump*>(trueTarget->terminator());
             if (nextCondJump) {
                 if (nextCondJump->condition() == jump.condition()) {
                     jump.setTrueTarget(nextCondJump->trueTarget());
@@ -73,13 +74,13 @@ void EmptyBlockEliminationVisitor::visit(ConditionalJump& jump) {
 
     BasicBlock* falseTarget = jump.falseTarget();
     if (falseTarget->instructions().empty() && falseTarget->terminator()) {
-        BasicJump* nextJump = dynamic_cast<BasicJump*>(falseTarget->terminator().get());
+        BasicJump* nextJump = dynamic_cast<BasicJump*>(falseTarget->terminator());
         if (nextJump) {
             jump.setFalseTarget(nextJump->target());
             setNeedSkip(falseTarget);
             m_changed = true;
         } else {
-            ConditionalJump* nextCondJump = dynamic_cast<ConditionalJump*>(falseTarget->terminator().get());
+            ConditionalJump* nextCondJump = dynamic_cast<ConditionalJump*>(falseTarget->terminator());
             if (nextCondJump) {
                 if (nextCondJump->condition() == jump.condition()) {
                     jump.setFalseTarget(nextCondJump->falseTarget());
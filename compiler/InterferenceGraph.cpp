@@ -1,17 +1,15 @@
 #include "InterferenceGraph.h"
 
-#include <algorithm>
-
 void InterferenceGraph::addInterference(LocalId a, LocalId b) {
     if (a == b) return;
 
-    if (std::find(m_interferences[a].begin(), m_interferences[a].end(), b) == m_interferences[a].end()) {
-        m_interferences[a].push_back(b);
-    }
+    size_t bit = matrixIndex(a, b);
+    uint64_t mask = uint64_t(1) << (bit % 64);
+    if (m_matrix[bit / 64] & mask) return;
 
-    if (std::find(m_interferences[b].begin(), m_interferences[b].end(), a) == m_interferences[b].end()) {
-        m_interferences[b].push_back(a);
-    }
+    m_matrix[bit / 64] |= mask;
+    m_interferences[a].push_back(b);
+    m_interferences[b].push_back(a);
 }
 
 void InterferenceGraph::printDot(std::ostream& out) const {
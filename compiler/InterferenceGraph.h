@@ -1,17 +1,25 @@
 #pragma once
 
+#include "LiveSet.h"
 #include <cstdint>
 #include <ostream>
+#include <utility>
 #include <vector>
 
-using LocalId = uint32_t;
-
 class InterferenceGraph {
   public:
-    explicit InterferenceGraph(size_t localCount) : m_interferences(localCount) {}
+    explicit InterferenceGraph(size_t localCount) :
+        m_interferences(localCount), m_matrix((localCount * (localCount - 1) / 2 + 63) / 64, 0) {}
 
     void addInterference(LocalId a, LocalId b);
 
+    bool interferes(LocalId a, LocalId b) const {
+        if (a == b)
+            return false;
+        size_t bit = matrixIndex(a, b);
+        return (m_matrix[bit / 64] >> (bit % 64)) & 1;
+    }
+
     const auto& neighbors(LocalId a) const { return m_interferences[a]; }
 
     size_t localCount() const { return m_interferences.size(); }
@@ -19,6 +27,15 @@ class InterferenceGraph {
     void printDot(std::ostream& out) const;
 
   private:
+    // Adjacency lists used to iterate over the neighbors of a local
     std::vector<std::vector<LocalId>> m_interferences;
-};
 
+    // Lower triangular bit matrix used to know in O(1) if an edge already exists
+    std::vector<uint64_t> m_matrix;
+
+    static size_t matrixIndex(LocalId a, LocalId b) {
+        if (a < b)
+            std::swap(a, b);
+        return size_t(a) * (a - 1) / 2 + b;
+    }
+};
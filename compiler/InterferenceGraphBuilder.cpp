@@ -0,0 +1,71 @@
+#include "InterferenceGraphBuilder.h"
+#include <ranges>
+#include <variant>
+
+using namespace ir;
+
+void InterferenceGraphBuilder::visit(ir::Function& function) {
+    for (auto& block : function.blocks()) {
+        visit(*block);
+    }
+    visit(*function.epilogue());
+    visit(*function.prologue());
+
+    // Nothing defines the locals live at the entry of the function so they must be linked here
+    for (LocalId local : m_liveOut) {
+        for (LocalId other : m_liveOut) {
+            m_interferenceGraph.addInterference(local, other);
+        }
+    }
+}
+
+void InterferenceGraphBuilder::visit(ir::BasicBlock& block) {
+    m_liveOut = m_livenessAnalysis[&block].second;
+
+    if (block.terminator()) {
+        visitBase(*block.terminator());
+    }
+
+    for (auto& instr : block.instructions() | std::views::reverse) {
+        visitBase(*instr);
+    }
+}
+
+void InterferenceGraphBuilder::visit(ir::BinaryOp& binaryOp) {
+    define(binaryOp.destination());
+    use(binaryOp.left());
+    use(binaryOp.right());
+}
+void InterferenceGraphBuilder::visit(ir::UnaryOp& unaryOp) {
+    define(unaryOp.destination());
+    use(unaryOp.operand());
+}
+void InterferenceGraphBuilder::visit(ir::Assignment& assignment) {
+    define(assignment.destination());
+    use(assignment.source());
+}
+void InterferenceGraphBuilder::visit(ir::Cast& cast) {
+    define(cast.destination());
+    use(cast.source());
+}
+void InterferenceGraphBuilder::visit(ir::ConditionalJump& jump) { use(jump.condition()); }
+void InterferenceGraphBuilder::visit(ir::Call& call) {
+    define(call.destination());
+    for (auto& arg : call.args()) {
+        use(arg);
+    }
+}
+void InterferenceGraphBuilder::visit(ir::PointerRead& read) {
+    define(read.destination());
+    use(read.address());
+}
+void InterferenceGraphBuilder::visit(ir::PointerWrite& write) {
+    use(write.address());
+    use(write.source());
+}
+void InterferenceGraphBuilder::visit(ir::AddressOf& address) {
+    define(address.destination());
+    if (std::holds_alternative<ir::Local>(address.source())) {
+        use(std::get<ir::Local>(address.source()));
+    }
+}
@@ -0,0 +1,54 @@
+#pragma once
+
+#include "BlockLivenessAnalysis.h"
+#include "InterferenceGraph.h"
+#include "ir/Ir.h"
+
+// Build the interference graph of a function from its liveness analysis.
+// Every defined local interferes with the locals live after its definition.
+// Locals live at the function entry (arguments, uninitialized variables) all interfere together.
+class InterferenceGraphBuilder : public ir::Visitor {
+  public:
+    using ir::Visitor::visit;
+
+    InterferenceGraphBuilder(BlockLivenessAnalysis& livenessAnalysis, InterferenceGraph& interferenceGraph) :
+        m_livenessAnalysis(livenessAnalysis), m_interferenceGraph(interferenceGraph) {}
+
+    void visit(ir::Function& function) override;
+    void visit(ir::BasicBlock& block) override;
+    void visit(ir::BinaryOp& binaryOp) override;
+    void visit(ir::UnaryOp& unaryOp) override;
+    void visit(ir::Assignment& assignment) override;
+    void visit(ir::ConditionalJump& jump) override;
+    void visit(ir::Call& call) override;
+    void visit(ir::Cast& cast) override;
+    void visit(ir::PointerRead& read) override;
+    void visit(ir::PointerWrite& write) override;
+    void visit(ir::AddressOf& address) override;
+
+  private:
+    BlockLivenessAnalysis& m_livenessAnalysis;
+    InterferenceGraph& m_interferenceGraph;
+
+    // Locals live after the instruction being visited
+    LiveSet m_liveOut;
+
+    void define(ir::Local local) {
+        for (LocalId other : m_liveOut) {
+            m_interferenceGraph.addInterference(local.id(), other);
+        }
+        m_liveOut.erase(local);
+    }
+
+    void use(ir::RValue rvalue) {
+        if (std::holds_alternative<ir::Local>(rvalue))
+            m_liveOut.insert(std::get<ir::Local>(rvalue));
+    }
+};
+
+inline InterferenceGraph computeInterferenceGraph(ir::Function& function, BlockLivenessAnalysis& livenessAnalysis) {
+    InterferenceGraph interferenceGraph{function.locals().size()};
+    InterferenceGraphBuilder builder{livenessAnalysis, interferenceGraph};
+    builder.visit(function);
+    return interferenceGraph;
+}
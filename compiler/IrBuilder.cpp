@@ -0,0 +1,522 @@
+#include "IrBuilder.h"
+#include "ir/Instructions.h"
+#include <string>
+
+using namespace ir;
+
+IrBuilder::IrBuilder(std::ostream& log) : m_log(log), m_symbolTable(m_identifiers, log) {
+    m_builtins.push_back(std::unique_ptr<Function>(new Function("putchar", {types::INT}, types::INT)));
+    m_builtins.push_back(std::unique_ptr<Function>(new Function("getchar", {}, types::INT)));
+    m_builtins.push_back(
+        std::unique_ptr<Function>(new Function("malloc", {types::LONG}, make_pointer_type(types::VOID)))
+    );
+    m_builtins.push_back(
+        std::unique_ptr<Function>(new Function("free", {make_pointer_type(types::VOID)}, types::VOID))
+    );
+    m_builtins.push_back(std::unique_ptr<Function>(
+        new Function("printf", {make_pointer_type(types::CHAR)}, types::INT, true)
+    ));
+
+    for (const auto& builtin : m_builtins) {
+        m_symbolTable.declareFunction(*builtin);
+    }
+}
+
+void IrBuilder::beginFunction(
+    const std::string& name, const Type* returnType, const std::vector<std::pair<std::string, const Type*>>& arguments
+) {
+    m_symbolTable.enterNewLocalScope();
+
+    m_functions.push_back(std::make_unique<Function>(name, arguments.size(), returnType));
+    m_currentFunction = m_functions.back().get();
+
+    m_symbolTable.declareFunction(*m_currentFunction);
+
+    for (const auto& [argName, type] : arguments) {
+        Local argLocal = m_currentFunction->newLocal(argName, type);
+        m_symbolTable.declareLocalVariable(argName, argLocal);
+    }
+
+    BasicBlock* prologue = m_currentFunction->prologue();
+    BasicBlock* content = m_currentFunction->newBlock();
+    BasicBlock* epilogue = m_currentFunction->epilogue();
+
+    prologue->terminate<BasicJump>(content);
+    content->terminate<BasicJump>(epilogue);
+
+    m_currentBlock = content;
+}
+
+bool IrBuilder::checkDeclaration(const Type* type, size_t count) {
+    if (type->isPtr() && count > 1) {
+        m_log << "Error: Multiple déclaration of pointers on the same line are forbidden" << std::endl;
+        m_error = true;
+        return false;
+    }
+    return true;
+}
+
+Local IrBuilder::declareVariable(const std::string& name, const Type* type) {
+    Local local = m_currentFunction->newLocal(name, type);
+    m_symbolTable.declareLocalVariable(name, local);
+    return local;
+}
+
+void IrBuilder::initializeVariable(Local variable, Local value) {
+    if (value.type() != variable.type()) {
+        value = emitCast(value, variable.type());
+    }
+    m_currentBlock->emit<Assignment>(variable, value);
+}
+
+void IrBuilder::emitReturn(std::optional<Local> value) {
+    if (value) {
+        Local res = *value;
+        Local returnLocal = m_currentFunction->returnLocal();
+
+        if (res.type() != returnLocal.type()) {
+            res = emitCast(res, returnLocal.type());
+        }
+
+        m_currentBlock->emit<Assignment>(returnLocal, res);
+    }
+
+    m_currentBlock->terminate<BasicJump>(m_currentFunction->epilogue());
+    startUnreachableBlock();
+}
+
+void IrBuilder::emitBreak() {
+    if (m_breakableScopes.empty()) {
+        m_error = true;
+        m_log << "Error: Break not in a loop";
+        return;
+    }
+
+    BasicBlock* endBlock = m_breakableScopes.back().first;
+    m_currentBlock->terminate<BasicJump>(endBlock);
+    startUnreachableBlock();
+}
+
+void IrBuilder::emitContinue() {
+    if (m_breakableScopes.empty()) {
+        m_error = true;
+        m_log << "Error: Continue not in a loop";
+        return;
+    }
+
+    BasicBlock* testBlock = m_breakableScopes.back().second;
+    m_currentBlock->terminate<BasicJump>(testBlock);
+    startUnreachableBlock();
+}
+
+void IrBuilder::startUnreachableBlock() {
+    BasicBlock* unreachableBlock = m_currentFunction->newBlock();
+    unreachableBlock->terminate<BasicJump>(m_currentFunction->epilogue());
+
+    m_currentBlock = unreachableBlock;
+}
+
+IrBuilder::If IrBuilder::beginIf(Local condition) {
+    BasicBlock* thenBlock = m_currentFunction->newBlock();
+    BasicBlock* elseBlock = m_currentFunction->newBlock();
+    BasicBlock* endBlock = m_currentFunction->newBlock();
+
+    endBlock->terminate<ConditionalJump>(condition, thenBlock, elseBlock);
+    std::swap(m_currentBlock->terminator(), endBlock->terminator());
+
+    thenBlock->terminate<BasicJump>(endBlock);
+    elseBlock->terminate<BasicJump>(endBlock);
+
+    m_currentBlock = thenBlock;
+    return {thenBlock, elseBlock, endBlock};
+}
+
+BasicBlock* IrBuilder::beginLoopTest() {
+    // Setup the test block
+    BasicBlock* testBlock = m_currentFunction->newBlock();
+    testBlock->terminate<BasicJump>(testBlock);
+    std::swap(m_currentBlock->terminator(), testBlock->terminator());
+
+    m_currentBlock = testBlock;
+    return testBlock;
+}
+
+IrBuilder::Loop IrBuilder::beginLoopBody(BasicBlock* testBlock, Local condition) {
+    BasicBlock* bodyBlock = m_currentFunction->newBlock();
+    BasicBlock* endBlock = m_currentFunction->newBlock();
+
+    endBlock->terminate<ConditionalJump>(condition, bodyBlock, endBlock);
+    std::swap(m_currentBlock->terminator(), endBlock->terminator());
+    bodyBlock->terminate<BasicJump>(testBlock);
+
+    m_currentBlock = bodyBlock;
+    m_breakableScopes.push_back({endBlock, testBlock});
+    return {testBlock, endBlock};
+}
+
+void IrBuilder::endLoop(const Loop& blocks) {
+    m_breakableScopes.pop_back();
+    m_currentBlock = blocks.endBlock;
+}
+
+Local IrBuilder::emitConst(std::string_view text) {
+    int value = std::stoi(std::string(text));
+    Local res = m_currentFunction->newLocal(types::INT);
+    m_currentBlock->emit<Assignment>(res, Immediate(value, types::INT));
+    return res;
+}
+
+Local IrBuilder::emitChar(std::string_view text) {
+    int value;
+    if (text[1] != '\\') {
+        value = text[1];
+    } else {
+        switch (text[2]) {
+            case 'n': value = '\n'; break;
+            case 'r': value = '\r'; break;
+            case 't': value = '\t'; break;
+            case '\'': value = '\''; break;
+            case '\\': value = '\\'; break;
+            case '0': value = '\0'; break;
+
+            // Default value should never reached due to grammar
+            default: value = 42; break;
+        }
+    }
+
+    Local res = m_currentFunction->newLocal(types::CHAR);
+    m_currentBlock->emit<Assignment>(res, Immediate(value, types::CHAR));
+    return res;
+}
+
+Local IrBuilder::emitString(std::string_view text) {
+    StringLiteral literal(m_literals.intern(text.substr(1, text.size() - 2)));
+    Local res = m_currentFunction->newLocal(make_pointer_type(types::CHAR));
+    m_currentBlock->emit<AddressOf>(res, literal);
+    return res;
+}
+
+LValueResult IrBuilder::lvalueVariable(const std::string& name) {
+    return LValueResult{m_symbolTable.getLocalVariable(name), false};
+}
+
+LValueResult IrBuilder::lvalueDeref(Local pointer) {
+    if (!pointer.type()->isPtr()) {
+        m_error = true;
+        m_log << "Pointer dereference could not be applied on type " << pointer.type()->name() << std::endl;
+        return LValueResult{m_currentFunction->invalidLocal(), true};
+    }
+
+    return LValueResult{pointer, true};
+}
+
+LValueResult IrBuilder::lvalueIndex(Local pointer, Local index) {
+    if (!pointer.type()->isPtr()) {
+        m_error = true;
+        m_log << "Could not index type " << pointer.type()->name() << std::endl;
+        return LValueResult{m_currentFunction->invalidLocal(), true};
+    }
+
+    return LValueResult{emitPointerBinaryOp(pointer, index, BinaryOpKind::ADD), true};
+}
+
+Local IrBuilder::emitRead(LValueResult lvalue) {
+    if (!lvalue.address) {
+        markAsRead(lvalue.local);
+        return lvalue.local;
+    } else {
+        Local res = m_currentFunction->newLocal(lvalue.local.type()->target());
+        m_currentBlock->emit<PointerRead>(res, lvalue.local);
+        return res;
+    }
+}
+
+Local IrBuilder::emitAssign(LValueResult lvalue, Local value) {
+    if (!lvalue.address) {
+        auto local = lvalue.local;
+        if (value.type() != local.type()) {
+            value = emitCast(value, local.type());
+        }
+        m_currentBlock->emit<Assignment>(local, value);
+    } else {
+        auto type = lvalue.local.type()->target();
+        if (value.type() != type) {
+            value = emitCast(value, type);
+        }
+
+        m_currentBlock->emit<PointerWrite>(lvalue.local, value);
+    }
+    return value;
+}
+
+Local IrBuilder::emitCompoundAssign(LValueResult lvalue, Local value, BinaryOpKind op) {
+    if (!lvalue.address) {
+        auto local = lvalue.local;
+        markAsRead(local);
+        if (value.type() != local.type()) {
+            // TODO: Check if this is right semantic
+            value = emitCast(value, local.type());
+        }
+
+        if (lvalue.local.type()->isPtr()) {
+            Local result = emitPointerBinaryOp(local, value, op);
+            m_currentBlock->emit<Assignment>(local, result);
+        } else {
+            m_currentBlock->emit<BinaryOp>(local, local, value, op);
+        }
+
+        return local;
+    } else {
+        auto local = m_currentFunction->newLocal(lvalue.local.type()->target());
+        m_currentBlock->emit<PointerRead>(local, lvalue.local);
+        if (local.type()->isPtr()) {
+            Local result = emitPointerBinaryOp(local, value, op);
+            m_currentBlock->emit<Assignment>(local, result);
+        } else {
+            m_currentBlock->emit<BinaryOp>(local, local, value, op);
+        }
+        m_currentBlock->emit<PointerWrite>(lvalue.local, local);
+
+        return local;
+    }
+}
+
+Local IrBuilder::emitAddressOf(LValueResult lvalue) {
+    if (lvalue.address) {
+        return lvalue.local;
+    } else {
+        Local res = m_currentFunction->newLocal(make_pointer_type(lvalue.local.type()));
+        m_currentBlock->emit<AddressOf>(res, lvalue.local);
+        return res;
+    }
+}
+
+Local IrBuilder::emitPreIncrDecr(LValueResult lvalue, BinaryOpKind op) {
+    if (!lvalue.address) {
+
+        markAsRead(lvalue.local);
+
+        if (lvalue.local.type()->isPtr()) {
+            Local one = m_currentFunction->newLocal(lvalue.local.type());
+            m_currentBlock->emit<Assignment>(one, Immediate(1, lvalue.local.type()));
+            Local addResult = emitPointerBinaryOp(lvalue.local, one, op);
+            m_currentBlock->emit<Assignment>(lvalue.local, addResult);
+        } else {
+            m_currentBlock->emit<BinaryOp>(lvalue.local, lvalue.local, Immediate(1, lvalue.local.type()), op);
+        }
+
+        return lvalue.local;
+    } else {
+        Local result = m_currentFunction->newLocal(lvalue.local.type()->target());
+        m_currentBlock->emit<PointerRead>(result, lvalue.local);
+
+        if (result.type()->isPtr()) {
+            Local one = m_currentFunction->newLocal(lvalue.local.type());
+            m_currentBlock->emit<Assignment>(one, Immediate(1, lvalue.local.type()));
+            Local addResult = emitPointerBinaryOp(result, one, op);
+            m_currentBlock->emit<PointerWrite>(lvalue.local, result);
+            m_currentBlock->emit<Assignment>(result, addResult);
+
+        } else {
+            m_currentBlock->emit<BinaryOp>(result, result, Immediate(1, result.type()), op);
+        }
+
+        m_currentBlock->emit<PointerWrite>(lvalue.local, result);
+
+        return result;
+    }
+}
+
+Local IrBuilder::emitPostIncrDecr(LValueResult lvalue, BinaryOpKind op) {
+    if (!lvalue.address) {
+
+        markAsRead(lvalue.local);
+        Local temp = m_currentFunction->newLocal(lvalue.local.type());
+        m_currentBlock->emit<Assignment>(temp, lvalue.local);
+        if (lvalue.local.type()->isPtr()) {
+            Local one = m_currentFunction->newLocal(lvalue.local.type());
+            m_currentBlock->emit<Assignment>(one, Immediate(1, lvalue.local.type()));
+            Local addResult = emitPointerBinaryOp(lvalue.local, one, op);
+            m_currentBlock->emit<Assignment>(lvalue.local, addResult);
+        } else {
+            m_currentBlock->emit<BinaryOp>(lvalue.local, lvalue.local, Immediate(1, lvalue.local.type()), op);
+        }
+
+        return temp;
+    } else {
+        Local temp = m_currentFunction->newLocal(lvalue.local.type()->target());
+        m_currentBlock->emit<PointerRead>(temp, lvalue.local);
+        if (temp.type()->isPtr()) {
+            Local one = m_currentFunction->newLocal(lvalue.local.type());
+            m_currentBlock->emit<Assignment>(one, Immediate(1, lvalue.local.type()));
+            Local result = emitPointerBinaryOp(temp, one, op);
+            m_currentBlock->emit<PointerWrite>(lvalue.local, result);
+        } else {
+            Local result = m_currentFunction->newLocal(temp.type());
+            m_currentBlock->emit<BinaryOp>(result, temp, Immediate(1, result.type()), op);
+            m_currentBlock->emit<PointerWrite>(lvalue.local, result);
+        }
+
+        return temp;
+    }
+}
+
+Local IrBuilder::emitPointerBinaryOp(Local left, Local right, BinaryOpKind op) {
+    if (left.type() != right.type()) {
+        right = emitCast(right, left.type());
+    }
+
+    // Every size is a power of two, the index is shifted instead of multiplied. void* and char* are not scaled
+    Local offset = right;
+    if (uint8_t shift = left.type()->target()->sizeLog2(); shift != 0) {
+        offset = m_currentFunction->newLocal(left.type());
+        m_currentBlock->emit<BinaryOp>(offset, right, Immediate(shift, left.type()), BinaryOpKind::SHL);
+    }
+
+    Local res = m_currentFunction->newLocal(left.type());
+    m_currentBlock->emit<BinaryOp>(res, left, offset, BinaryOpKind::ADD);
+
+    return res;
+}
+
+Local IrBuilder::emitBinaryOp(Local left, Local right, BinaryOpKind op) {
+    if (left.type()->isPtr() && (op == BinaryOpKind::ADD || op == BinaryOpKind::SUB)) {
+        return emitPointerBinaryOp(left, right, op);
+    }
+
+    if (right.type()->isPtr() && op == BinaryOpKind::ADD) {
+        return emitPointerBinaryOp(right, left, op);
+    }
+
+    if (left.type()->isPtr() || right.type()->isPtr()) {
+        m_error = true;
+        m_log << "Invalid operand types '" << left.type()->name() << "' and '" << right.type()->name()
+              << "' for operator " << op << std::endl;
+
+        return m_currentFunction->invalidLocal();
+    }
+
+    const Type* resType;
+    if (left.type() == right.type()) {
+        resType = left.type();
+    } else if (left.type()->size() < right.type()->size()) {
+        resType = right.type();
+        left = emitCast(left, resType);
+    } else {
+        resType = left.type();
+        right = emitCast(right, resType);
+    }
+
+    // Comparisons give a bool whatever the type of their operands
+    switch (op) {
+        case BinaryOpKind::EQ:
+        case BinaryOpKind::NEQ:
+        case BinaryOpKind::CMP_L:
+        case BinaryOpKind::CMP_G:
+        case BinaryOpKind::CMP_LE:
+        case BinaryOpKind::CMP_GE: resType = types::BOOL; break;
+        default: break;
+    }
+
+    Local res = m_currentFunction->newLocal(resType);
+    m_currentBlock->emit<BinaryOp>(res, left, right, op);
+    return res;
+}
+
+Local IrBuilder::emitUnaryOp(Local operand, UnaryOpKind op, bool comp) {
+    auto resType = operand.type();
+    if (comp) {
+        resType = types::BOOL;
+    }
+    Local res = m_currentFunction->newLocal(resType);
+    m_currentBlock->emit<UnaryOp>(res, operand, op);
+    return res;
+}
+
+Local IrBuilder::emitCast(Local source, const Type* targetType) {
+    Local res = m_currentFunction->newLocal(targetType);
+    m_currentBlock->emit<Cast>(res, source);
+    return res;
+}
+
+IrBuilder::ShortCircuit IrBuilder::beginLogicalOr(Local left) {
+    BasicBlock* orBlock = m_currentFunction->newBlock();
+    BasicBlock* endBlock = m_currentFunction->newBlock();
+
+    endBlock->terminate<ConditionalJump>(left, endBlock, orBlock);
+    std::swap(m_currentBlock->terminator(), endBlock->terminator());
+
+    orBlock->terminate<BasicJump>(endBlock);
+
+    m_currentBlock = orBlock;
+    return {left, endBlock};
+}
+
+IrBuilder::ShortCircuit IrBuilder::beginLogicalAnd(Local left) {
+    BasicBlock* andBlock = m_currentFunction->newBlock();
+    BasicBlock* endBlock = m_currentFunction->newBlock();
+
+    endBlock->terminate<ConditionalJump>(left, andBlock, endBlock);
+    std::swap(m_currentBlock->terminator(), endBlock->terminator());
+
+    andBlock->terminate<BasicJump>(endBlock);
+
+    m_currentBlock = andBlock;
+    return {left, endBlock};
+}
+
+Local IrBuilder::endShortCircuit(const ShortCircuit& pending, Local right) {
+    m_currentBlock->emit<Assignment>(pending.result, right);
+    m_currentBlock = pending.endBlock;
+    return pending.result;
+}
+
+IrBuilder::PendingCall IrBuilder::beginCall(std::string_view name) {
+    // A function which was never declared is not interned, its call is an error
+    Symbol symbol = globalSymbols.find(name);
+    const Function* function = m_symbolTable.findFunction(symbol);
+    const Type* returnType = function ? function->returnLocal().type() : types::VOID;
+    return PendingCall{symbol, function, m_currentFunction->newLocal(returnType), {}};
+}
+
+void IrBuilder::addArgument(PendingCall& call, Local arg) {
+    size_t i = call.args.size() + 1;
+    if (call.function && i <= call.function->argCount()) {
+        auto argType = call.function->locals()[i].type();
+        if (arg.type() != argType) {
+            arg = emitCast(arg, argType);
+        }
+    }
+    call.args.push_back(arg);
+}
+
+Local IrBuilder::endCall(PendingCall& call) {
+    if (!m_symbolTable.checkFunction(call.name, call.args.size())) {
+        return call.result;
+    }
+
+    m_currentBlock->emit<ir::Call>(call.result, call.name, std::move(call.args), call.function->variadic());
+    return call.result;
+}
+
+BinaryOpKind IrBuilder::binaryOpKind(std::string_view op) {
+    // Compound assignments like "+=" apply the operation before the '='
+    if (op.size() == 2 && op[1] == '=' && op[0] != '=' && op[0] != '!' && op[0] != '<' && op[0] != '>') {
+        op = op.substr(0, 1);
+    }
+
+    if (op == "+") return BinaryOpKind::ADD;
+    if (op == "-") return BinaryOpKind::SUB;
+    if (op == "*") return BinaryOpKind::MUL;
+    if (op == "/") return BinaryOpKind::DIV;
+    if (op == "%") return BinaryOpKind::MOD;
+    if (op == "==") return BinaryOpKind::EQ;
+    if (op == "!=") return BinaryOpKind::NEQ;
+    if (op == "<") return BinaryOpKind::CMP_L;
+    if (op == ">") return BinaryOpKind::CMP_G;
+    if (op == "<=") return BinaryOpKind::CMP_LE;
+    if (op == ">=") return BinaryOpKind::CMP_GE;
+    if (op == "&") return BinaryOpKind::BIT_AND;
+    if (op == "^") return BinaryOpKind::BIT_XOR;
+    return BinaryOpKind::BIT_OR;
+}
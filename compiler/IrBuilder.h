@@ -0,0 +1,158 @@
+#pragma once
+
+#include "IrSymbolTable.h"
+#include "StringInterner.h"
+#include "Type.h"
+#include "ir/Function.h"
+#include "ir/Ir.h"
+#include <iostream>
+#include <memory>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+struct LValueResult {
+    ir::Local local;
+    bool address; // Wether local should be consider as an address or not
+};
+
+// Emits the IR of each construct of the language in the current block of the current function.
+// It is shared by the two front ends : IrGenVisitor which walks the parse tree built by ANTLR, and
+// IrParser which emits the IR while parsing. Both call it in evaluation order so they build the same IR.
+class IrBuilder {
+  public:
+    // Blocks of an if statement
+    struct If {
+        ir::BasicBlock* thenBlock;
+        ir::BasicBlock* elseBlock;
+        ir::BasicBlock* endBlock;
+    };
+
+    // Blocks of a while loop
+    struct Loop {
+        ir::BasicBlock* testBlock;
+        ir::BasicBlock* endBlock;
+    };
+
+    // Pending || or && : result holds the left operand until the right one is known
+    struct ShortCircuit {
+        ir::Local result;
+        ir::BasicBlock* endBlock;
+    };
+
+    // Pending call, the result is allocated before the arguments are evaluated
+    struct PendingCall {
+        Symbol name;
+        // Null when the function is not declared
+        const ir::Function* function;
+        ir::Local result;
+        std::vector<ir::RValue> args;
+    };
+
+    // Semantic errors and warnings are printed to log
+    explicit IrBuilder(std::ostream& log = std::cerr);
+
+    void beginFunction(
+        const std::string& name, const Type* returnType,
+        const std::vector<std::pair<std::string, const Type*>>& arguments
+    );
+
+    void enterScope() { m_symbolTable.enterNewLocalScope(); }
+    void exitScope() { m_symbolTable.exitLocalScope(); }
+
+    // Check that count variables of this type can be declared in the same statement
+    bool checkDeclaration(const Type* type, size_t count);
+    ir::Local declareVariable(const std::string& name, const Type* type);
+    void initializeVariable(ir::Local variable, ir::Local value);
+
+    void emitReturn(std::optional<ir::Local> value);
+    void emitBreak();
+    void emitContinue();
+
+    // Emit the condition jump and continue in the then block
+    If beginIf(ir::Local condition);
+    // Continue in the else block
+    void beginElse(const If& blocks) { m_currentBlock = blocks.elseBlock; }
+    void endIf(const If& blocks) { m_currentBlock = blocks.endBlock; }
+
+    // Continue in a new block where the condition of the loop is evaluated
+    ir::BasicBlock* beginLoopTest();
+    // Emit the condition jump and continue in the body of the loop
+    Loop beginLoopBody(ir::BasicBlock* testBlock, ir::Local condition);
+    void endLoop(const Loop& blocks);
+
+    ir::Local emitConst(std::string_view text);
+    // text is the literal with its quotes
+    ir::Local emitChar(std::string_view text);
+    ir::Local emitString(std::string_view text);
+
+    LValueResult lvalueVariable(const std::string& name);
+    LValueResult lvalueDeref(ir::Local pointer);
+    LValueResult lvalueIndex(ir::Local pointer, ir::Local index);
+
+    ir::Local emitRead(LValueResult lvalue);
+    ir::Local emitAssign(LValueResult lvalue, ir::Local value);
+    ir::Local emitCompoundAssign(LValueResult lvalue, ir::Local value, ir::BinaryOpKind op);
+    ir::Local emitAddressOf(LValueResult lvalue);
+    ir::Local emitPreIncrDecr(LValueResult lvalue, ir::BinaryOpKind op);
+    ir::Local emitPostIncrDecr(LValueResult lvalue, ir::BinaryOpKind op);
+
+    ir::Local emitBinaryOp(ir::Local left, ir::Local right, ir::BinaryOpKind op);
+    ir::Local emitPointerBinaryOp(ir::Local left, ir::Local right, ir::BinaryOpKind op);
+    ir::Local emitUnaryOp(ir::Local operand, ir::UnaryOpKind op, bool comp = false);
+    ir::Local emitCast(ir::Local source, const Type* targetType);
+
+    // The right operand is evaluated in a new block only reached when the left one does not decide the result
+    ShortCircuit beginLogicalOr(ir::Local left);
+    ShortCircuit beginLogicalAnd(ir::Local left);
+    ir::Local endShortCircuit(const ShortCircuit& pending, ir::Local right);
+
+    PendingCall beginCall(std::string_view name);
+    void addArgument(PendingCall& call, ir::Local arg);
+    ir::Local endCall(PendingCall& call);
+
+    // Operation of a binary operator, or of a compound assignment operator like "+="
+    static ir::BinaryOpKind binaryOpKind(std::string_view op);
+    static ir::BinaryOpKind incrDecrOpKind(std::string_view op) {
+        return op == "++" ? ir::BinaryOpKind::ADD : ir::BinaryOpKind::SUB;
+    }
+
+    const auto& functions() const { return m_functions; }
+
+    // String literals of every function, by StringLiteral id
+    const StringInterner& literals() const { return m_literals; }
+
+    bool hasErrors() const { return m_symbolTable.hasErrors() || m_error; }
+
+    std::ostream& log() const { return m_log; }
+
+    void markAsRead(ir::Local local) {
+        if (local.id() >= m_currentFunction->locals().size()) {
+            return;
+        }
+
+        auto nameOpt = m_currentFunction->locals()[local.id()].name();
+        if (nameOpt) {
+            m_symbolTable.markAsUsed(nameOpt.value());
+        }
+    }
+
+  private:
+    std::ostream& m_log;
+    // Declarations of the functions of the C library usable without declaring them
+    std::vector<std::unique_ptr<ir::Function>> m_builtins;
+    std::vector<std::unique_ptr<ir::Function>> m_functions;
+    ir::Function* m_currentFunction;
+    ir::BasicBlock* m_currentBlock;
+    // Names of the variables of the translation unit, only function names are global symbols
+    StringInterner m_identifiers;
+    IrSymbolTable m_symbolTable;
+    StringInterner m_literals;
+    std::vector<std::pair<ir::BasicBlock*, ir::BasicBlock*>> m_breakableScopes; // (breakBlock, continueBlock)
+    bool m_error = false;
+
+    // Continue in a new block, for the code following a jump
+    void startUnreachableBlock();
+};
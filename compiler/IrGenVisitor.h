@@ -1,15 +1,21 @@
 #pragma once
 
-#include "IrSymbolTable.h"
+#include "IrBuilder.h"
 #include "generated/ifccBaseVisitor.h"
 #include "generated/ifccParser.h"
-#include "ir/Function.h"
 #include "ir/Ir.h"
-#include <vector>
+#include <optional>
 
+// Front end walking the parse tree built by ANTLR, the IR is emitted by the builder
 class IrGenVisitor : public ifccBaseVisitor {
   public:
-    IrGenVisitor();
+    explicit IrGenVisitor(IrBuilder& builder) : m_builder(builder) {}
+
+    // Typed entry points for the expressions. The visit methods of the expressions and of the lvalues are
+    // adapters storing their result in m_value or m_lvalue, a Local boxed in a std::any is allocated on the heap
+    ir::Local lowerExpr(ifccParser::ExprContext* ctx);
+    LValueResult lowerLvalue(antlr4::tree::ParseTree* ctx);
+
     std::any visitFunction(ifccParser::FunctionContext *ctx) override;
     std::any visitReturn_stmt(ifccParser::Return_stmtContext* ctx) override;
     std::any visitBreak(ifccParser::BreakContext *ctx) override;
@@ -48,10 +54,6 @@ class IrGenVisitor : public ifccBaseVisitor {
     std::any visitPar(ifccParser::ParContext* ctx) override { return visit(ctx->expr()); }
     std::any visitLvaluePar(ifccParser::LvalueParContext *ctx) override { return visit(ctx->lvalue()); }
 
-    std::any visitBinaryOp(ifccParser::ExprContext* left, ifccParser::ExprContext* right, ir::BinaryOpKind op, bool comp = false);
-    ir::Local visitPointerBinaryOp(ir::Local left, ir::Local right, ir::BinaryOpKind op);
-    std::any visitUnaryOp(ifccParser::ExprContext* operand, ir::UnaryOpKind op, bool comp = false);
-
     std::any visitSimpleType(ifccParser::SimpleTypeContext *ctx) override;
     std::any visitPointerType(ifccParser::PointerTypeContext *ctx) override;
 
@@ -61,28 +63,20 @@ class IrGenVisitor : public ifccBaseVisitor {
     std::any visitLvalueIndexPar(ifccParser::LvalueIndexParContext *ctx) override;
     std::any visitAddressOf(ifccParser::AddressOfContext *ctx) override;
 
-    ir::Local emitCast(ir::Local source, const Type* targetType);
-
-    const auto& functions() const { return m_functions; }
-
-    bool hasErrors() const { return m_symbolTable.hasErrors() || m_error; }
-
-    void markAsRead(ir::Local local) {
-        if (local.id() >= m_currentFunction->locals().size()) {
-            return;
-        }
-
-        auto nameOpt = m_currentFunction->locals()[local.id()].name();
-        if (nameOpt) {
-            m_symbolTable.markAsUsed(nameOpt.value());
-        }
+  private:
+    IrBuilder& m_builder;
+    // Result of the last expression or lvalue visited
+    std::optional<ir::Local> m_value;
+    std::optional<LValueResult> m_lvalue;
+
+    std::any setValue(ir::Local value) {
+        m_value = value;
+        return {};
+    }
+    std::any setLvalue(LValueResult lvalue) {
+        m_lvalue = lvalue;
+        return {};
     }
 
-  private:
-    std::vector<std::unique_ptr<ir::Function>> m_functions;
-    ir::Function* m_currentFunction;
-    ir::BasicBlock* m_currentBlock;
-    IrSymbolTable m_symbolTable;
-    std::vector<std::pair<ir::BasicBlock*, ir::BasicBlock*>> m_breakableScopes; // (breakBlock, continueBlock)
-    bool m_error = false;
+    ir::Local lowerBinaryOp(ifccParser::ExprContext* left, ifccParser::ExprContext* right, ir::BinaryOpKind op);
 };
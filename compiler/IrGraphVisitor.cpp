@@ -15,7 +15,7 @@ void IrGraphVisitor::visit(ir::Function& function) {
 }
 
 void IrGraphVisitor::visit(ir::BasicBlock& block) {
-    m_currentBlockLabel = block.label();
+    m_currentBlockLabel = block.label().str();
     std::ranges::replace(m_currentBlockLabel, '.', '_');
     m_out << m_currentBlockLabel << "[label = \"" << block.label() << ":\\l";
     for (const auto& instr : block.instructions()) {
@@ -29,14 +29,14 @@ void IrGraphVisitor::visit(ir::BasicBlock& block) {
 }
 
 void IrGraphVisitor::visit(ir::BasicJump& jump) {
-    string targetLabel = jump.target()->label();
+    string targetLabel = jump.target()->label().str();
     std::ranges::replace(targetLabel, '.', '_');
     m_out << m_currentBlockLabel << " -> " << targetLabel << endl;
 }
 void IrGraphVisitor::visit(ir::ConditionalJump& jump) {
-    string trueTargetLabel = jump.trueTarget()->label();
+    string trueTargetLabel = jump.trueTarget()->label().str();
     std::ranges::replace(trueTargetLabel, '.', '_');
-    string falseTargetLabel = jump.falseTarget()->label();
+    string falseTargetLabel = jump.falseTarget()->label().str();
     std::ranges::replace(falseTargetLabel, '.', '_');
     m_out << m_currentBlockLabel << " -> " << trueTargetLabel << " [label = \"" << jump.condition() << "\"]" << endl;
     m_out << m_currentBlockLabel << " -> " << falseTargetLabel << " [label = \"not " << jump.condition() << "\"]" << endl;
@@ -0,0 +1,537 @@
+#include "IrParser.h"
+
+#include <iostream>
+#include <stdexcept>
+
+using namespace antlr4;
+using namespace ir;
+
+namespace {
+    // Precedence of the binary operators in ifcc.g4, the first alternative binds the tightest
+    constexpr int PRODUCT_PRECEDENCE = 15;
+    constexpr int SUM_PRECEDENCE = 14;
+    constexpr int CMP_PRECEDENCE = 13;
+    constexpr int EQ_PRECEDENCE = 12;
+    constexpr int BIT_AND_PRECEDENCE = 11;
+    constexpr int BIT_XOR_PRECEDENCE = 10;
+    constexpr int BIT_OR_PRECEDENCE = 9;
+    constexpr int LOGICAL_AND_PRECEDENCE = 8;
+    constexpr int LOGICAL_OR_PRECEDENCE = 7;
+    // Operand of the unary '+' and '-', and of '!'
+    constexpr int UNARY_SUM_PRECEDENCE = 19;
+    constexpr int UNARY_PRECEDENCE = 18;
+}
+
+IrParser::IrParser(
+    const std::vector<Token*>& tokens, std::string_view text, const dfa::Vocabulary& vocabulary, IrBuilder& builder
+) :
+    m_text(text), m_builder(builder) {
+    for (Token* token : tokens) {
+        if (token->getChannel() == Token::DEFAULT_CHANNEL) {
+            m_tokens.push_back(token);
+        }
+    }
+    if (m_tokens.empty() || m_tokens.back()->getType() != Token::EOF) {
+        throw std::runtime_error("The token stream does not end with EOF");
+    }
+
+    initTokenTypes(vocabulary);
+}
+
+IrParser::IrParser(TokenSource& lexer, std::string_view text, const dfa::Vocabulary& vocabulary, IrBuilder& builder) :
+    m_lexer(&lexer), m_text(text), m_builder(builder) {
+    initTokenTypes(vocabulary);
+}
+
+void IrParser::initTokenTypes(const dfa::Vocabulary& vocabulary) {
+    auto tokenType = [&](std::string_view name) {
+        for (size_t type = 1; type <= vocabulary.getMaxTokenType(); type++) {
+            if (vocabulary.getSymbolicName(type) == name || vocabulary.getLiteralName(type) == name) {
+                return type;
+            }
+        }
+        throw std::runtime_error("Token " + std::string(name) + " is not in the grammar");
+    };
+
+    m_leftPar = tokenType("'('");
+    m_comma = tokenType("','");
+    m_rightPar = tokenType("')'");
+    m_semicolon = tokenType("';'");
+    m_leftBrace = tokenType("'{'");
+    m_rightBrace = tokenType("'}'");
+    m_equal = tokenType("'='");
+    m_leftBracket = tokenType("'['");
+    m_rightBracket = tokenType("']'");
+
+    m_return = tokenType("RETURN");
+    m_flatType = tokenType("FLAT_TYPE");
+    m_if = tokenType("IF");
+    m_while = tokenType("WHILE");
+    m_else = tokenType("ELSE");
+    m_break = tokenType("BREAK");
+    m_continue = tokenType("CONTINUE");
+    m_star = tokenType("STAR");
+    m_assignOp = tokenType("ASSIGN_OP");
+    m_sumOp = tokenType("SUM_OP");
+    m_incrDecrOp = tokenType("INCRDECR_OP");
+    m_unaryOp = tokenType("UNARY_OP");
+    m_productOp = tokenType("PRODUCT_OP");
+    m_cmpOp = tokenType("CMP_OP");
+    m_eqOp = tokenType("EQ_OP");
+    m_bitAnd = tokenType("BIT_AND");
+    m_bitXor = tokenType("BIT_XOR");
+    m_bitOr = tokenType("BIT_OR");
+    m_logicalAnd = tokenType("LOGICAL_AND");
+    m_logicalOr = tokenType("LOGICAL_OR");
+    m_char = tokenType("CHAR");
+    m_string = tokenType("STRING");
+    m_const = tokenType("CONST");
+    m_ident = tokenType("IDENT");
+}
+
+bool IrParser::parse() {
+    Status status;
+    do {
+        status = parseNextFunction();
+    } while (status == Status::FUNCTION);
+    return status == Status::END;
+}
+
+IrParser::Status IrParser::parseNextFunction() {
+    if (m_lexer) {
+        lexFunction();
+    }
+    if (peek() == Token::EOF) {
+        return Status::END;
+    }
+
+    try {
+        parseFunction();
+    } catch (SyntaxError&) {
+        return Status::SYNTAX_ERROR;
+    }
+    return Status::FUNCTION;
+}
+
+void IrParser::lexFunction() {
+    // Nothing references the tokens of the previous function anymore
+    m_tokens.clear();
+    m_ownedTokens.clear();
+    m_position = 0;
+
+    // A function ends with the brace closing its body. A stray '}' is kept alone, the parser reports it. When the
+    // braces are not balanced the rest of the input is read, so the lookahead sees the same tokens as in a full
+    // token stream until the error
+    size_t depth = 0;
+    while (true) {
+        std::unique_ptr<Token> token = m_lexer->nextToken();
+        if (token->getChannel() != Token::DEFAULT_CHANNEL) {
+            continue;
+        }
+
+        size_t type = token->getType();
+        m_tokens.push_back(token.get());
+        m_ownedTokens.push_back(std::move(token));
+        if (type == Token::EOF || (type == m_rightBrace && (depth == 0 || --depth == 0))) {
+            break;
+        }
+        if (type == m_leftBrace) {
+            depth++;
+        }
+    }
+}
+
+std::string_view IrParser::text(size_t offset) const {
+    Token* token = this->token(offset);
+    if (token->getType() == Token::EOF) {
+        return "";
+    }
+    return m_text.substr(token->getStartIndex(), token->getStopIndex() - token->getStartIndex() + 1);
+}
+
+std::string_view IrParser::expect(size_t type) {
+    if (peek() != type) {
+        syntaxError();
+    }
+    std::string_view res = text();
+    m_position++;
+    return res;
+}
+
+void IrParser::syntaxError() {
+    Token* token = this->token();
+    m_builder.log() << "line " << token->getLine() << ":" << token->getCharPositionInLine() << " syntax error at '"
+                    << (token->getType() == Token::EOF ? "<EOF>" : text()) << "'" << std::endl;
+    throw SyntaxError{};
+}
+
+void IrParser::parseFunction() {
+    const Type* returnType = parseType();
+    std::string name(expect(m_ident));
+
+    std::vector<std::pair<std::string, const Type*>> arguments;
+    expect(m_leftPar);
+    if (peek() != m_rightPar) {
+        while (true) {
+            const Type* type = parseType();
+            arguments.emplace_back(expect(m_ident), type);
+            if (peek() != m_comma) {
+                break;
+            }
+            m_position++;
+        }
+    }
+    expect(m_rightPar);
+
+    m_builder.beginFunction(name, returnType, arguments);
+    parseBlock();
+}
+
+const Type* IrParser::parseType() {
+    const Type* type = make_simple_type(expect(m_flatType));
+    while (peek() == m_star) {
+        m_position++;
+        type = make_pointer_type(type);
+    }
+    return type;
+}
+
+void IrParser::parseStatement() {
+    size_t type = peek();
+    if (type == m_leftBrace) {
+        parseBlock();
+    } else if (type == m_if) {
+        parseIf();
+    } else if (type == m_while) {
+        parseWhile();
+    } else if (type == m_flatType) {
+        parseDeclaration();
+    } else if (type == m_return) {
+        parseReturn();
+    } else if (type == m_break) {
+        m_position++;
+        expect(m_semicolon);
+        m_builder.emitBreak();
+    } else if (type == m_continue) {
+        m_position++;
+        expect(m_semicolon);
+        m_builder.emitContinue();
+    } else {
+        parseValue(0, false);
+        expect(m_semicolon);
+    }
+}
+
+void IrParser::parseBlock() {
+    expect(m_leftBrace);
+    m_builder.enterScope();
+    while (peek() != m_rightBrace) {
+        parseStatement();
+    }
+    m_position++;
+    m_builder.exitScope();
+}
+
+void IrParser::parseIf() {
+    expect(m_if);
+    expect(m_leftPar);
+    Local cond = parseValue(0, false);
+    expect(m_rightPar);
+
+    IrBuilder::If blocks = m_builder.beginIf(cond);
+    parseStatement();
+
+    // The else goes with the innermost if
+    if (peek() == m_else) {
+        m_position++;
+        m_builder.beginElse(blocks);
+        parseStatement();
+    }
+
+    m_builder.endIf(blocks);
+}
+
+void IrParser::parseWhile() {
+    expect(m_while);
+    expect(m_leftPar);
+    BasicBlock* testBlock = m_builder.beginLoopTest();
+    Local testRes = parseValue(0, false);
+    expect(m_rightPar);
+
+    IrBuilder::Loop blocks = m_builder.beginLoopBody(testBlock, testRes);
+    parseStatement();
+    m_builder.endLoop(blocks);
+}
+
+void IrParser::parseDeclaration() {
+    const Type* type = parseType();
+
+    // Only the declarations of pointers depend on the number of variables
+    if (type->isPtr()) {
+        auto [count, end] = scanDeclaration();
+        if (!m_builder.checkDeclaration(type, count)) {
+            m_position = end + 1;
+            return;
+        }
+    }
+
+    while (true) {
+        std::string name(expect(m_ident));
+        Local local = m_builder.declareVariable(name, type);
+
+        // Variable is initialized
+        if (peek() == m_equal) {
+            m_position++;
+            Local res = parseValue(0, false);
+            m_builder.initializeVariable(local, res);
+        }
+
+        if (peek() != m_comma) {
+            break;
+        }
+        m_position++;
+    }
+    expect(m_semicolon);
+}
+
+void IrParser::parseReturn() {
+    expect(m_return);
+
+    std::optional<Local> value;
+    if (peek() != m_semicolon) {
+        value = parseValue(0, false);
+    }
+    expect(m_semicolon);
+
+    m_builder.emitReturn(value);
+}
+
+IrParser::Operand IrParser::parseExpr(int minPrecedence, bool noAssign) {
+    Operand left = parsePrimary(noAssign);
+
+    while (true) {
+        size_t type = peek();
+        int precedence = this->precedence(type);
+        if (precedence == 0 || precedence < minPrecedence) {
+            break;
+        }
+        std::string_view op = text();
+        m_position++;
+
+        Local leftRes = toValue(left);
+        if (type == m_logicalOr || type == m_logicalAnd) {
+            IrBuilder::ShortCircuit pending =
+                type == m_logicalOr ? m_builder.beginLogicalOr(leftRes) : m_builder.beginLogicalAnd(leftRes);
+            Local rightRes = parseValue(precedence + 1, noAssign);
+            left = {{m_builder.endShortCircuit(pending, rightRes), false}, false};
+        } else {
+            BinaryOpKind kind = type == m_star ? BinaryOpKind::MUL : IrBuilder::binaryOpKind(op);
+            Local rightRes = parseValue(precedence + 1, noAssign);
+            left = {{m_builder.emitBinaryOp(leftRes, rightRes, kind), false}, false};
+        }
+    }
+
+    return left;
+}
+
+IrParser::Operand IrParser::parsePrimary(bool noAssign) {
+    size_t type = peek();
+
+    if (type == m_const) {
+        return {{m_builder.emitConst(expect(m_const)), false}, false};
+    }
+    if (type == m_char) {
+        return {{m_builder.emitChar(expect(m_char)), false}, false};
+    }
+    if (type == m_string) {
+        return {{m_builder.emitString(expect(m_string)), false}, false};
+    }
+
+    if (type == m_sumOp) {
+        bool minus = text() == "-";
+        m_position++;
+        Local operand = parseValue(UNARY_SUM_PRECEDENCE, noAssign);
+        if (minus) {
+            operand = m_builder.emitUnaryOp(operand, UnaryOpKind::MINUS);
+        }
+        return {{operand, false}, false};
+    }
+    if (type == m_unaryOp) {
+        m_position++;
+        Local operand = parseValue(UNARY_PRECEDENCE, noAssign);
+        return {{m_builder.emitUnaryOp(operand, UnaryOpKind::NOT, true), false}, false};
+    }
+    if (type == m_bitAnd) {
+        m_position++;
+        LValueResult lvalue = parseLvalue(noAssign);
+        return {{m_builder.emitAddressOf(lvalue), false}, false};
+    }
+    if (type == m_incrDecrOp) {
+        BinaryOpKind op = IrBuilder::incrDecrOpKind(text());
+        m_position++;
+        LValueResult lvalue = parseLvalue(noAssign);
+        return {{m_builder.emitPreIncrDecr(lvalue, op), false}, false};
+    }
+
+    if (type == m_star) {
+        // The pointer expression stops before an assignment, which is taken by the dereference
+        m_position++;
+        LValueResult lvalue = m_builder.lvalueDeref(parseValue(0, true));
+        return parseAssignment({lvalue, true}, noAssign);
+    }
+
+    if (type == m_ident && peek(1) == m_leftPar) {
+        return {{parseCall(), false}, false};
+    }
+    if (type != m_ident && type != m_leftPar) {
+        syntaxError();
+    }
+
+    Operand operand = type == m_ident ? Operand{parseVariable(), true} : parseParenthesized();
+    if (operand.isLvalue && peek() == m_incrDecrOp) {
+        BinaryOpKind op = IrBuilder::incrDecrOpKind(text());
+        m_position++;
+        return {{m_builder.emitPostIncrDecr(operand.lvalue, op), false}, false};
+    }
+
+    return parseAssignment(operand, noAssign);
+}
+
+IrParser::Operand IrParser::parseAssignment(const Operand& operand, bool noAssign) {
+    size_t type = peek();
+    if (noAssign || !operand.isLvalue || (type != m_equal && type != m_assignOp)) {
+        return operand;
+    }
+
+    std::string_view op = text();
+    m_position++;
+    Local res = parseValue(0, false);
+
+    if (type == m_assignOp) {
+        return {{m_builder.emitCompoundAssign(operand.lvalue, res, IrBuilder::binaryOpKind(op)), false}, false};
+    } else {
+        return {{m_builder.emitAssign(operand.lvalue, res), false}, false};
+    }
+}
+
+LValueResult IrParser::parseLvalue(bool noAssign) {
+    size_t type = peek();
+
+    if (type == m_star) {
+        // Nothing can be assigned after '&' or '++', so the pointer expression takes the assignment
+        m_position++;
+        return m_builder.lvalueDeref(parseValue(0, noAssign));
+    }
+
+    if (type == m_ident) {
+        return parseVariable();
+    }
+
+    if (type == m_leftPar) {
+        Operand operand = parseParenthesized();
+        if (operand.isLvalue) {
+            return operand.lvalue;
+        }
+    }
+
+    syntaxError();
+}
+
+LValueResult IrParser::parseVariable() {
+    std::string name(expect(m_ident));
+    if (peek() == m_leftBracket) {
+        return parseIndex(m_builder.lvalueVariable(name).local);
+    }
+    return m_builder.lvalueVariable(name);
+}
+
+IrParser::Operand IrParser::parseParenthesized() {
+    // "(*x = 5)" can be both the lvalue *(x = 5) and the assignment through x, ANTLR takes the lvalue.
+    // It is not an lvalue when indexed, the parentheses then hold an expression
+    bool derefLvalue = peek(1) == m_star && peekAfterParentheses() != m_leftBracket;
+
+    expect(m_leftPar);
+    Operand operand = derefLvalue ? parseDerefLvalue() : parseExpr(0, false);
+    expect(m_rightPar);
+
+    if (peek() == m_leftBracket) {
+        return {parseIndex(toValue(operand)), true};
+    }
+    return operand;
+}
+
+IrParser::Operand IrParser::parseDerefLvalue() {
+    expect(m_star);
+    LValueResult lvalue = m_builder.lvalueDeref(parseValue(0, false));
+    // The assignment was not valid inside the pointer expression, like in "(*p + 1 = 5)"
+    return parseAssignment({lvalue, true}, false);
+}
+
+LValueResult IrParser::parseIndex(Local pointer) {
+    expect(m_leftBracket);
+    Local index = parseValue(0, false);
+    expect(m_rightBracket);
+    return m_builder.lvalueIndex(pointer, index);
+}
+
+Local IrParser::parseCall() {
+    IrBuilder::PendingCall call = m_builder.beginCall(expect(m_ident));
+    expect(m_leftPar);
+    if (peek() != m_rightPar) {
+        while (true) {
+            m_builder.addArgument(call, parseValue(0, false));
+            if (peek() != m_comma) {
+                break;
+            }
+            m_position++;
+        }
+    }
+    expect(m_rightPar);
+
+    return m_builder.endCall(call);
+}
+
+size_t IrParser::peekAfterParentheses() const {
+    size_t depth = 0;
+    for (size_t i = m_position; i < m_tokens.size(); i++) {
+        size_t type = m_tokens[i]->getType();
+        if (type == m_leftPar) {
+            depth++;
+        } else if (type == m_rightPar && --depth == 0) {
+            return peek(i + 1 - m_position);
+        }
+    }
+    return Token::EOF;
+}
+
+std::pair<size_t, size_t> IrParser::scanDeclaration() const {
+    size_t count = 1;
+    size_t depth = 0;
+    size_t i = m_position;
+    for (; i < m_tokens.size() - 1; i++) {
+        size_t type = m_tokens[i]->getType();
+        if (type == m_leftPar || type == m_leftBracket) {
+            depth++;
+        } else if ((type == m_rightPar || type == m_rightBracket) && depth > 0) {
+            depth--;
+        } else if (type == m_comma && depth == 0) {
+            count++;
+        } else if (type == m_semicolon && depth == 0) {
+            break;
+        }
+    }
+    return {count, i};
+}
+
+int IrParser::precedence(size_t type) const {
+    if (type == m_star || type == m_productOp) return PRODUCT_PRECEDENCE;
+    if (type == m_sumOp) return SUM_PRECEDENCE;
+    if (type == m_cmpOp) return CMP_PRECEDENCE;
+    if (type == m_eqOp) return EQ_PRECEDENCE;
+    if (type == m_bitAnd) return BIT_AND_PRECEDENCE;
+    if (type == m_bitXor) return BIT_XOR_PRECEDENCE;
+    if (type == m_bitOr) return BIT_OR_PRECEDENCE;
+    if (type == m_logicalAnd) return LOGICAL_AND_PRECEDENCE;
+    if (type == m_logicalOr) return LOGICAL_OR_PRECEDENCE;
+    return 0;
+}
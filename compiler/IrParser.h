@@ -0,0 +1,116 @@
+#pragma once
+
+#include "IrBuilder.h"
+#include "antlr4-runtime.h"
+#include <algorithm>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// Front end emitting the IR while parsing, without building a parse tree. It is enabled with -ffast-frontend.
+//
+// Statements are parsed by recursive descent and expressions by precedence climbing, following ifcc.g4 and the
+// way ANTLR resolves its ambiguities so the builder is called in the same order as by IrGenVisitor:
+//  - binary operators are left associative, unary '-' and '!' bind tighter than every binary operator
+//  - '*' takes the whole expression following it as the pointer, so "*p + 1" reads at p + 1
+//  - an assignment is taken by the outermost lvalue, so "*x = 5" writes through x, except right inside
+//    parentheses where "(*x = 5)" is an lvalue reading at x once 5 is assigned to x
+class IrParser {
+  public:
+    enum class Status { FUNCTION, END, SYNTAX_ERROR };
+
+    // tokens is the whole token stream, hidden tokens included, and text the source they were lexed from
+    IrParser(
+        const std::vector<antlr4::Token*>& tokens, std::string_view text, const antlr4::dfa::Vocabulary& vocabulary,
+        IrBuilder& builder
+    );
+
+    // Streaming mode, used by -fstreaming: the tokens are pulled from lexer one function at a time and released
+    // once the function is parsed, so only the tokens of the current function are in memory
+    IrParser(
+        antlr4::TokenSource& lexer, std::string_view text, const antlr4::dfa::Vocabulary& vocabulary,
+        IrBuilder& builder
+    );
+
+    // Return false on a syntax error, it has already been reported
+    bool parse();
+
+    // Parse the next function of the input, it is then the last function of the builder.
+    // A syntax error has already been reported when SYNTAX_ERROR is returned
+    Status parseNextFunction();
+
+  private:
+    // An lvalue is only read once it is known not to be assigned
+    struct Operand {
+        LValueResult lvalue; // lvalue.local is the value when isLvalue is false
+        bool isLvalue;
+    };
+
+    struct SyntaxError {};
+
+    std::vector<antlr4::Token*> m_tokens;
+    size_t m_position = 0;
+    // Streaming mode only, null otherwise
+    antlr4::TokenSource* m_lexer = nullptr;
+    // Tokens of the current function in streaming mode
+    std::vector<std::unique_ptr<antlr4::Token>> m_ownedTokens;
+    std::string_view m_text;
+    IrBuilder& m_builder;
+
+    size_t m_leftPar, m_comma, m_rightPar, m_semicolon, m_leftBrace, m_rightBrace, m_equal, m_leftBracket,
+        m_rightBracket;
+    size_t m_return, m_flatType, m_if, m_while, m_else, m_break, m_continue, m_star, m_assignOp, m_sumOp,
+        m_incrDecrOp, m_unaryOp, m_productOp, m_cmpOp, m_eqOp, m_bitAnd, m_bitXor, m_bitOr, m_logicalAnd,
+        m_logicalOr, m_char, m_string, m_const, m_ident;
+
+    antlr4::Token* token(size_t offset = 0) const {
+        return m_tokens[std::min(m_position + offset, m_tokens.size() - 1)];
+    }
+    size_t peek(size_t offset = 0) const { return token(offset)->getType(); }
+    std::string_view text(size_t offset = 0) const;
+    std::string_view expect(size_t type);
+    [[noreturn]] void syntaxError();
+    // Pull the tokens up to the brace closing the next function in streaming mode
+    void lexFunction();
+    void initTokenTypes(const antlr4::dfa::Vocabulary& vocabulary);
+
+    void parseFunction();
+    const Type* parseType();
+    void parseStatement();
+    void parseBlock();
+    void parseIf();
+    void parseWhile();
+    void parseDeclaration();
+    void parseReturn();
+
+    // Operators binding at least as tight as minPrecedence. With noAssign an lvalue is not assigned, the assignment
+    // belongs to an enclosing '*'
+    Operand parseExpr(int minPrecedence, bool noAssign);
+    Operand parsePrimary(bool noAssign);
+    ir::Local parseValue(int minPrecedence, bool noAssign) { return toValue(parseExpr(minPrecedence, noAssign)); }
+    // Assign the lvalue when an assignment operator follows
+    Operand parseAssignment(const Operand& operand, bool noAssign);
+    // Operand of '&' and of a prefix '++' or '--'
+    LValueResult parseLvalue(bool noAssign);
+    // Variable, indexed or not
+    LValueResult parseVariable();
+    // Parenthesized expression and the index following it
+    Operand parseParenthesized();
+    // Dereference right inside parentheses, its pointer expression takes the assignments
+    Operand parseDerefLvalue();
+    LValueResult parseIndex(ir::Local pointer);
+    ir::Local parseCall();
+
+    ir::Local toValue(const Operand& operand) {
+        return operand.isLvalue ? m_builder.emitRead(operand.lvalue) : operand.lvalue.local;
+    }
+
+    // Type of the token following the parenthesis opening at the current token and its closing one
+    size_t peekAfterParentheses() const;
+    // Number of variables of the declaration at the current token, and the position of its ';'
+    std::pair<size_t, size_t> scanDeclaration() const;
+
+    // Precedence of the binary operator, 0 if the token is not one
+    int precedence(size_t type) const;
+};
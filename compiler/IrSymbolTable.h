@@ -1,85 +1,103 @@
 #pragma once
 
+#include "StringInterner.h"
 #include "ir/Function.h"
 #include "ir/Instructions.h"
+#include <cstdint>
 #include <iostream>
-#include <ranges>
+#include <stdexcept>
 #include <string>
+#include <string_view>
 #include <unordered_map>
-#include <unordered_set>
 #include <vector>
 
+// Variables live in a single stack of bindings. Each identifier is interned into a dense id which indexes its
+// innermost binding, and every binding links to the one it shadows: a lookup is O(1) and leaving a scope only
+// touches the bindings of the scope. The identifiers are interned in the interner of the translation unit, so a
+// long-lived process such as the compile server does not keep the identifiers of every file it compiled.
 class IrSymbolTable {
   public:
+    // Identifiers are interned in identifiers, errors and warnings are printed to log
+    IrSymbolTable(StringInterner& identifiers, std::ostream& log) : m_identifiers(identifiers), m_log(log) {}
+
     bool hasErrors() const { return m_error; }
 
-    void enterNewLocalScope() { m_localScopeStack.emplace_back(); }
+    void enterNewLocalScope() { m_scopeStarts.push_back(m_bindings.size()); }
 
-    void exitLocalScope() { 
-        auto scope = std::move(m_localScopeStack.back());
-        m_localScopeStack.pop_back(); 
+    void exitLocalScope() {
+        size_t start = m_scopeStarts.back();
+        m_scopeStarts.pop_back();
 
-        for (const auto& unusedVariable : scope.second) {
-            std::cerr << "Warning: Variable " << unusedVariable << " not used." << std::endl;
+        for (size_t i = start; i < m_bindings.size(); i++) {
+            if (!m_used[i]) {
+                m_log << "Warning: Variable " << m_identifiers.text(m_bindings[i].identifier) << " not used."
+                      << std::endl;
+            }
         }
+
+        // In reverse order so each identifier gets back the binding it shadowed
+        for (size_t i = m_bindings.size(); i-- > start;) {
+            m_innermost[m_bindings[i].identifier] = m_bindings[i].shadowed;
+        }
+        m_bindings.erase(m_bindings.begin() + start, m_bindings.end());
+        m_used.resize(start);
     }
 
-    void declareLocalVariable(std::string str, ir::Local localVariable) {
-        VariableScope& currentScope = m_localScopeStack.back();
+    void declareLocalVariable(std::string_view str, ir::Local localVariable) {
+        Symbol identifier = m_identifiers.intern(str);
+        if (identifier >= m_innermost.size()) {
+            m_innermost.resize(identifier + 1, NO_BINDING);
+        }
 
-        if (currentScope.first.contains(str)) {
+        uint32_t shadowed = m_innermost[identifier];
+        if (shadowed != NO_BINDING && shadowed >= m_scopeStarts.back()) {
             m_error = true;
-            std::cerr << "Error: Variable " << str << " already declared in this scope." << std::endl;
+            m_log << "Error: Variable " << str << " already declared in this scope." << std::endl;
             return;
         }
-        currentScope.second.insert(str);
-        currentScope.first.insert({std::move(str), localVariable});
+
+        m_innermost[identifier] = m_bindings.size();
+        m_bindings.push_back({localVariable, identifier, shadowed});
+        m_used.push_back(false);
     }
 
-    ir::Local getLocalVariable(const std::string& str) {
-        for (auto& scope : m_localScopeStack | std::views::reverse) {
-            auto it = scope.first.find(str);
-            if (it != scope.first.end()) {
-                return it->second;
-            }
+    ir::Local getLocalVariable(std::string_view str) {
+        uint32_t binding = innermost(m_identifiers.find(str));
+        if (binding != NO_BINDING) {
+            return m_bindings[binding].local;
         }
 
-        std::cerr << "Error: Variable " << str << " not declared in this scope." << std::endl;
+        m_log << "Error: Variable " << str << " not declared in this scope." << std::endl;
         m_error = true;
 
         // We return a Local but the IR won't be valid anyway since we have undeclared variables
         return ir::Local{INT32_MAX, types::VOID};
     }
 
-    void markAsUsed(const std::string& str) {
-        for (auto& scope : m_localScopeStack | std::views::reverse) {
-            auto it = scope.first.find(str);
-            if (it != scope.first.end()) {
-                scope.second.erase(str);
-            }
+    // The variables shadowed by the one in scope are marked as used too
+    void markAsUsed(std::string_view str) {
+        uint32_t binding = innermost(m_identifiers.find(str));
+        while (binding != NO_BINDING) {
+            m_used[binding] = true;
+            binding = m_bindings[binding].shadowed;
         }
-
     }
 
     void declareFunction(const ir::Function& function) {
-
-        if (m_functions.contains(function.name())) {
+        if (!m_functions.emplace(function.symbol(), &function).second) {
             m_error = true;
-            std::cerr << "Error: Function " << function.name() << " already declared in this scope." << std::endl;
-            return;
+            m_log << "Error: Function " << function.name() << " already declared in this scope." << std::endl;
         }
-
-        m_functions.insert({function.name(), &function});
     }
 
-    bool checkFunction(const std::string& name, size_t argCount) {
-        auto it = m_functions.find(name);
-        if (it == m_functions.end()) {
+    bool checkFunction(Symbol name, size_t argCount) {
+        const ir::Function* function = findFunction(name);
+        if (!function) {
             m_error = true;
             return false;
         }
 
-        if (it->second->argCount() != argCount && !(it->second->variadic() && it->second->argCount() <= argCount)) {
+        if (function->argCount() != argCount && !(function->variadic() && function->argCount() <= argCount)) {
             m_error = true;
             return false;
         }
@@ -87,14 +105,47 @@ class IrSymbolTable {
         return true;
     }
 
-    const ir::Function* getFunction(const std::string& name) {
-        return m_functions.at(name);
+    // Return null if the function is not declared
+    const ir::Function* findFunction(Symbol name) const {
+        auto it = m_functions.find(name);
+        return it != m_functions.end() ? it->second : nullptr;
     }
 
-  private:
-    using VariableScope = std::pair<std::unordered_map<std::string, ir::Local>, std::unordered_set<std::string>>;
+    const ir::Function* getFunction(Symbol name) {
+        const ir::Function* function = findFunction(name);
+        if (!function) {
+            throw std::out_of_range("Unknown function " + globalSymbols.text(name));
+        }
+        return function;
+    }
 
-    std::vector<VariableScope> m_localScopeStack;
-    std::unordered_map<std::string, const ir::Function*> m_functions;
+  private:
+    static constexpr uint32_t NO_BINDING = UINT32_MAX;
+
+    StringInterner& m_identifiers;
+    std::ostream& m_log;
+
+    struct Binding {
+        ir::Local local;
+        Symbol identifier;
+        // Binding of the same identifier in an enclosing scope
+        uint32_t shadowed;
+    };
+
+    // Innermost binding of each identifier
+    std::vector<uint32_t> m_innermost;
+    std::vector<Binding> m_bindings;
+    // Whether each binding has been read
+    std::vector<bool> m_used;
+    // Index in m_bindings of the first binding of each scope
+    std::vector<size_t> m_scopeStarts;
+    // Declared functions by the global symbol of their name. Function names are shared by every file of the
+    // process, a vector indexed by symbol would grow with all the names the process has seen
+    std::unordered_map<Symbol, const ir::Function*> m_functions;
     bool m_error = false;
+
+    // NO_BINDING for the identifiers which are not in scope, including StringInterner::NONE
+    uint32_t innermost(Symbol identifier) const {
+        return identifier < m_innermost.size() ? m_innermost[identifier] : NO_BINDING;
+    }
 };
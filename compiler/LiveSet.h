@@ -0,0 +1,131 @@
+#pragma once
+
+#include "ir/Instructions.h"
+#include <algorithm>
+#include <bit>
+#include <cstdint>
+#include <vector>
+
+using LocalId = uint32_t;
+
+// Set of locals stored as a bitset indexed by LocalId.
+// Unions and differences work on a whole word (64 locals) at a time.
+class LiveSet {
+  public:
+    class Iterator {
+      public:
+        Iterator(const std::vector<uint64_t>& words, size_t wordIndex) : m_words(&words), m_wordIndex(wordIndex) {
+            m_remaining = m_wordIndex < m_words->size() ? (*m_words)[m_wordIndex] : 0;
+            skipEmptyWords();
+        }
+
+        LocalId operator*() const { return m_wordIndex * 64 + std::countr_zero(m_remaining); }
+
+        Iterator& operator++() {
+            // Clear the lowest set bit
+            m_remaining &= m_remaining - 1;
+            skipEmptyWords();
+            return *this;
+        }
+
+        bool operator==(const Iterator& other) const {
+            return m_wordIndex == other.m_wordIndex && m_remaining == other.m_remaining;
+        }
+
+      private:
+        const std::vector<uint64_t>* m_words;
+        size_t m_wordIndex;
+        uint64_t m_remaining;
+
+        void skipEmptyWords() {
+            while (m_remaining == 0 && m_wordIndex < m_words->size()) {
+                m_wordIndex++;
+                m_remaining = m_wordIndex < m_words->size() ? (*m_words)[m_wordIndex] : 0;
+            }
+        }
+    };
+
+    LiveSet() = default;
+    explicit LiveSet(size_t localCount) : m_words((localCount + 63) / 64, 0) {}
+
+    bool contains(LocalId local) const {
+        size_t word = local / 64;
+        return word < m_words.size() && (m_words[word] >> (local % 64)) & 1;
+    }
+    bool contains(ir::Local local) const { return contains(local.id()); }
+
+    // Add a local to the set, return true if it was not already in it
+    bool insert(LocalId local) {
+        size_t word = local / 64;
+        if (word >= m_words.size()) {
+            m_words.resize(word + 1, 0);
+        }
+
+        uint64_t mask = uint64_t(1) << (local % 64);
+        bool inserted = !(m_words[word] & mask);
+        m_words[word] |= mask;
+        return inserted;
+    }
+    bool insert(ir::Local local) { return insert(local.id()); }
+
+    void erase(LocalId local) {
+        size_t word = local / 64;
+        if (word < m_words.size()) {
+            m_words[word] &= ~(uint64_t(1) << (local % 64));
+        }
+    }
+    void erase(ir::Local local) { erase(local.id()); }
+
+    void clear() { std::ranges::fill(m_words, 0); }
+
+    bool empty() const {
+        return std::ranges::all_of(m_words, [](uint64_t word) { return word == 0; });
+    }
+
+    size_t size() const {
+        size_t count = 0;
+        for (auto word : m_words) {
+            count += std::popcount(word);
+        }
+        return count;
+    }
+
+    // this = this | other. Return true if the set changed
+    bool unionWith(const LiveSet& other) {
+        if (other.m_words.size() > m_words.size()) {
+            m_words.resize(other.m_words.size(), 0);
+        }
+
+        bool changed = false;
+        for (size_t i = 0; i < other.m_words.size(); i++) {
+            uint64_t added = other.m_words[i] & ~m_words[i];
+            m_words[i] |= added;
+            changed |= added != 0;
+        }
+
+        return changed;
+    }
+
+    // this = this & ~other
+    void subtract(const LiveSet& other) {
+        size_t count = std::min(m_words.size(), other.m_words.size());
+        for (size_t i = 0; i < count; i++) {
+            m_words[i] &= ~other.m_words[i];
+        }
+    }
+
+    // this = this & other
+    void intersect(const LiveSet& other) {
+        for (size_t i = 0; i < m_words.size(); i++) {
+            m_words[i] &= i < other.m_words.size() ? other.m_words[i] : 0;
+        }
+    }
+
+    Iterator begin() const { return Iterator(m_words, 0); }
+    Iterator end() const { return Iterator(m_words, m_words.size()); }
+
+    const auto& words() const { return m_words; }
+
+  private:
+    std::vector<uint64_t> m_words;
+};
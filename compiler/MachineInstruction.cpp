@@ -0,0 +1,107 @@
+#include "MachineInstruction.h"
+
+static std::string_view mnemonic(X86Opcode opcode) {
+    switch (opcode) {
+        case X86Opcode::LABEL: return "";
+        case X86Opcode::MOV: return "mov";
+        case X86Opcode::MOVS: return "movs";
+        case X86Opcode::LEA: return "lea";
+        case X86Opcode::ADD: return "add";
+        case X86Opcode::SUB: return "sub";
+        case X86Opcode::IMUL: return "imul";
+        case X86Opcode::AND: return "and";
+        case X86Opcode::XOR: return "xor";
+        case X86Opcode::OR: return "or";
+        case X86Opcode::SHL: return "shl";
+        case X86Opcode::NEG: return "neg";
+        case X86Opcode::CMP: return "cmp";
+        case X86Opcode::TEST: return "test";
+        case X86Opcode::IDIV: return "idiv";
+        case X86Opcode::SIGN_EXTEND_ACCUMULATOR: return "";
+        case X86Opcode::SET: return "set";
+        case X86Opcode::J: return "j";
+        case X86Opcode::JMP: return "jmp";
+        case X86Opcode::PUSH: return "push";
+        case X86Opcode::POP: return "pop";
+        case X86Opcode::CALL: return "call";
+        case X86Opcode::RET: return "ret";
+    }
+
+    throw std::runtime_error("Unknown opcode");
+}
+
+static std::string_view conditionSuffix(ConditionCode condition) {
+    switch (condition) {
+        case ConditionCode::E: return "e";
+        case ConditionCode::NE: return "ne";
+        case ConditionCode::L: return "l";
+        case ConditionCode::G: return "g";
+        case ConditionCode::LE: return "le";
+        case ConditionCode::GE: return "ge";
+        case ConditionCode::Z: return "z";
+    }
+
+    throw std::runtime_error("Unknown condition");
+}
+
+static void printOperand(AsmBuffer& out, const Operand& operand) {
+    std::visit(
+        [&](const auto& operand) {
+            using T = std::decay_t<decltype(operand)>;
+            if constexpr (std::is_same_v<T, SizedRegister>) {
+                out << registerLabel(operand);
+            } else if constexpr (std::is_same_v<T, Deref>) {
+                out << "(" << registerLabel(operand.reg) << ")";
+            } else if constexpr (std::is_same_v<T, DerefOffset>) {
+                out << operand.offset << "(" << registerLabel(operand.reg) << ")";
+            } else if constexpr (std::is_same_v<T, ImmediateOperand>) {
+                out << "$" << operand.value;
+            } else if constexpr (std::is_same_v<T, Label>) {
+                out << operand.block->label();
+            } else if constexpr (std::is_same_v<T, FunctionLabel>) {
+                out << globalSymbols.text(operand.function) << "@PLT";
+            } else if constexpr (std::is_same_v<T, DataLabel>) {
+                out << ".L.str." << operand.literal << "(%rip)";
+            }
+        },
+        operand
+    );
+}
+
+void printInstruction(AsmBuffer& out, const MachineInstruction& instruction) {
+    if (instruction.opcode == X86Opcode::LABEL) {
+        out << std::get<Label>(instruction.operands[0]).block->label() << ":\t\n";
+        return;
+    }
+
+    out << "\t";
+    switch (instruction.opcode) {
+        case X86Opcode::SIGN_EXTEND_ACCUMULATOR:
+            switch (instruction.size) {
+                case 8: out << "cqto"; break;
+                case 4: out << "cltd"; break;
+                case 2: out << "cwtd"; break;
+                case 1: out << "cbtw"; break;
+                default: throw std::runtime_error("Unsupported size");
+            }
+            break;
+        case X86Opcode::MOVS:
+            out << "movs" << getSuffix(instruction.sourceSize) << getSuffix(instruction.size);
+            break;
+        case X86Opcode::SET:
+        case X86Opcode::J: out << mnemonic(instruction.opcode) << conditionSuffix(instruction.condition); break;
+        default:
+            out << mnemonic(instruction.opcode);
+            if (instruction.size != 0) {
+                out << getSuffix(instruction.size);
+            }
+    }
+    out << "\t";
+
+    for (size_t i = 0; i < instruction.operandCount; i++) {
+        if (i != 0)
+            out << ", ";
+        printOperand(out, instruction.operands[i]);
+    }
+    out << "\n";
+}
@@ -0,0 +1,160 @@
+#pragma once
+
+#include "AsmBuffer.h"
+#include "ir/BasicBlock.h"
+#include <array>
+#include <cstdint>
+#include <ostream>
+#include <stdexcept>
+#include <string_view>
+#include <variant>
+
+enum class Register : uint8_t {
+    RAX = 0,
+    RBX = 1,
+    RCX = 2,
+    RDX = 3,
+    RSI = 4,
+    RDI = 5,
+    RSP = 6,
+    RBP = 7,
+    R8 = 8,
+    R9 = 9,
+    R10 = 10,
+    R11 = 11,
+    R12 = 12,
+    R13 = 13,
+    R14 = 14,
+    R15 = 15,
+};
+
+struct SizedRegister {
+    Register reg;
+    size_t size;
+
+    bool operator==(const SizedRegister&) const = default;
+};
+
+struct Deref {
+    SizedRegister reg;
+
+    bool operator==(const Deref&) const = default;
+};
+
+struct DerefOffset {
+    SizedRegister reg;
+    int offset;
+
+    bool operator==(const DerefOffset&) const = default;
+};
+
+// Value already truncated to the size of the instruction
+struct ImmediateOperand {
+    int64_t value;
+
+    bool operator==(const ImmediateOperand&) const = default;
+};
+
+// Label of a block of the current function
+struct Label {
+    const ir::BasicBlock* block;
+
+    bool operator==(const Label&) const = default;
+};
+
+// Function called through the PLT
+struct FunctionLabel {
+    Symbol function;
+
+    bool operator==(const FunctionLabel&) const = default;
+};
+
+// String literal of the translation unit
+struct DataLabel {
+    uint32_t literal;
+
+    bool operator==(const DataLabel&) const = default;
+};
+
+using Operand = std::variant<SizedRegister, Deref, DerefOffset, ImmediateOperand, Label, FunctionLabel, DataLabel>;
+
+enum class X86Opcode : uint8_t {
+    // Not a real instruction, the position of a block label
+    LABEL,
+    MOV,
+    // Sign extending move from sourceSize to size
+    MOVS,
+    LEA,
+    ADD,
+    SUB,
+    IMUL,
+    AND,
+    XOR,
+    OR,
+    // Shift left by an immediate
+    SHL,
+    NEG,
+    CMP,
+    TEST,
+    IDIV,
+    // Sign extend the accumulator into rdx before a division : cqto, cltd, cwtd or cbtw depending on size
+    SIGN_EXTEND_ACCUMULATOR,
+    SET,
+    J,
+    JMP,
+    PUSH,
+    POP,
+    CALL,
+    RET,
+};
+
+enum class ConditionCode : uint8_t { E, NE, L, G, LE, GE, Z };
+
+// One x86 instruction in AT&T operand order (source first)
+struct MachineInstruction {
+    X86Opcode opcode;
+
+    // Size of the operands in bytes, gives the suffix of the mnemonic. 0 when the mnemonic has no suffix
+    uint8_t size = 0;
+
+    // Size of the source of a MOVS
+    uint8_t sourceSize = 0;
+
+    // Condition of a SET or a J
+    ConditionCode condition = ConditionCode::E;
+
+    uint8_t operandCount = 0;
+    std::array<Operand, 2> operands;
+};
+
+inline const std::string_view REGISTER_ALIASES[16][4]{
+    {"%rax", "%eax", "%ax", "%al"},      {"%rbx", "%ebx", "%bx", "%bl"},      {"%rcx", "%ecx", "%cx", "%cl"},
+    {"%rdx", "%edx", "%dx", "%dl"},      {"%rsi", "%esi", "%si", "%sil"},     {"%rdi", "%edi", "%di", "%dil"},
+    {"%rsp", "%esp", "%sp", "%spl"},     {"%rbp", "%ebp", "%bp", "%bpl"},     {"%r8", "%r8d", "%r8w", "%r8b"},
+    {"%r9", "%r9d", "%r9w", "%r9b"},     {"%r10", "%r10d", "%r10w", "%r10b"}, {"%r11", "%r11d", "%r11w", "%r11b"},
+    {"%r12", "%r12d", "%r12w", "%r12b"}, {"%r13", "%r13d", "%r13w", "%r13b"}, {"%r14", "%r14d", "%r14w", "%r14b"},
+    {"%r15", "%r15d", "%r15w", "%r15b"},
+};
+
+inline std::string_view registerLabel(SizedRegister reg) {
+    switch (reg.size) {
+        case 8: return REGISTER_ALIASES[uint8_t(reg.reg)][0];
+        case 4: return REGISTER_ALIASES[uint8_t(reg.reg)][1];
+        case 2: return REGISTER_ALIASES[uint8_t(reg.reg)][2];
+        case 1: return REGISTER_ALIASES[uint8_t(reg.reg)][3];
+        default: throw std::runtime_error("Unsupported size");
+    }
+}
+
+inline std::string_view getSuffix(size_t size) {
+    switch (size) {
+        case 8: return "q";
+        case 4: return "l";
+        case 2: return "w";
+        case 1: return "b";
+        default: throw std::runtime_error("Unsupported size");
+    }
+}
+
+// Append an instruction in GNU assembler syntax to out
+void printInstruction(AsmBuffer& out, const MachineInstruction& instruction);
@@ -0,0 +1,52 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <exception>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Call f(i) for every i in [0, count) using up to threadCount threads.
+// Indices are handed out one at a time so long and short tasks get balanced between threads.
+// The first exception thrown by f is rethrown once every thread has stopped.
+template <class F>
+void parallelFor(size_t count, unsigned threadCount, F&& f) {
+    threadCount = std::max(1u, std::min<unsigned>(threadCount, count));
+    if (threadCount == 1) {
+        for (size_t i = 0; i < count; i++) {
+            f(i);
+        }
+        return;
+    }
+
+    std::atomic<size_t> next = 0;
+    std::exception_ptr error;
+    std::mutex errorMutex;
+
+    auto worker = [&]() {
+        for (size_t i = next++; i < count; i = next++) {
+            try {
+                f(i);
+            } catch (...) {
+                std::lock_guard lock(errorMutex);
+                if (!error)
+                    error = std::current_exception();
+                // Make the other threads stop as soon as possible
+                next = count;
+            }
+        }
+    };
+
+    std::vector<std::jthread> threads;
+    for (unsigned i = 1; i < threadCount; i++) {
+        threads.emplace_back(worker);
+    }
+    worker();
+    threads.clear();
+
+    if (error) {
+        std::rethrow_exception(error);
+    }
+}
@@ -0,0 +1,202 @@
+#include "PassManager.h"
+#include "BlockReordering.h"
+#include "ConstantFolding.h"
+#include "DeadCodeElimination.h"
+#include "EmptyBlockElimination.h"
+#include "IrValuePropagationVisitor.h"
+#include "TwoStepAssignmentElimination.h"
+#include <algorithm>
+#include <ostream>
+
+PointedLocals& AnalysisCache::pointedLocals() {
+    if (!m_pointedLocals) {
+        m_pointedLocals = computePointedLocals(m_function);
+    }
+    return *m_pointedLocals;
+}
+
+DependanceMap& AnalysisCache::dependanceMap() {
+    if (!m_dependanceMap) {
+        m_dependanceMap = computeDependanceMap(m_function);
+    }
+    return *m_dependanceMap;
+}
+
+BlockLivenessAnalysis& AnalysisCache::liveness() {
+    if (!m_liveness) {
+        m_liveness = computeBlockLivenessAnalysis(m_function, dependanceMap());
+    }
+    return *m_liveness;
+}
+
+void AnalysisCache::invalidate(AnalysisSet preserved) {
+    // Liveness is computed from the dependance map
+    if (!(preserved & analyses::DEPENDANCE_MAP)) {
+        preserved &= ~analyses::LIVENESS;
+    }
+
+    if (!(preserved & analyses::POINTED_LOCALS)) {
+        m_pointedLocals.reset();
+    }
+    if (!(preserved & analyses::DEPENDANCE_MAP)) {
+        m_dependanceMap.reset();
+    }
+    if (!(preserved & analyses::LIVENESS)) {
+        m_liveness.reset();
+    }
+}
+
+void PassManager::run(ir::Function& function, CompileReport* report) {
+    AnalysisCache cache{function};
+
+    bool changed;
+    do {
+        changed = false;
+        for (auto& pass : m_passes) {
+            bool passChanged;
+            {
+                CompileReport::Scope scope(report, pass->name());
+                passChanged = pass->run(function, cache);
+            }
+
+            if (passChanged) {
+                cache.invalidate(pass->preserved());
+                changed = true;
+            }
+        }
+    } while (changed);
+}
+
+namespace {
+    class ValuePropagationPass : public Pass {
+      public:
+        std::string_view name() const override { return "propagate"; }
+        AnalysisSet preserved() const override { return analyses::POINTED_LOCALS | analyses::DEPENDANCE_MAP; }
+
+        bool run(ir::Function& function, AnalysisCache& cache) override {
+            IrValuePropagationVisitor propagator{cache.pointedLocals()};
+            propagator.visit(function);
+            return propagator.changed();
+        }
+    };
+
+    class DeadCodeEliminationPass : public Pass {
+      public:
+        std::string_view name() const override { return "dce"; }
+        // A removed AddressOf may leave a local no longer pointed
+        AnalysisSet preserved() const override { return analyses::DEPENDANCE_MAP; }
+
+        bool run(ir::Function& function, AnalysisCache& cache) override {
+            DeadCodeElimination deadCodeElimination{cache.liveness(), cache.pointedLocals()};
+            deadCodeElimination.visit(function);
+            return deadCodeElimination.changed();
+        }
+    };
+
+    class ConstantFoldingPass : public Pass {
+      public:
+        std::string_view name() const override { return "fold"; }
+        // Conditional jumps with a constant condition are replaced so the CFG may change
+        AnalysisSet preserved() const override { return analyses::POINTED_LOCALS; }
+
+        bool run(ir::Function& function, AnalysisCache&) override {
+            ConstantFoldingVisitor folding;
+            folding.visit(function);
+            return folding.changed();
+        }
+    };
+
+    class TwoStepAssignmentEliminationPass : public Pass {
+      public:
+        std::string_view name() const override { return "two-step"; }
+        AnalysisSet preserved() const override { return analyses::DEPENDANCE_MAP; }
+
+        bool run(ir::Function& function, AnalysisCache& cache) override {
+            TwoStepAssignmentEliminationVisitor elimination{cache.liveness(), cache.pointedLocals()};
+            elimination.visit(function);
+            return elimination.changed();
+        }
+    };
+
+    class EmptyBlockEliminationPass : public Pass {
+      public:
+        std::string_view name() const override { return "empty-blocks"; }
+        AnalysisSet preserved() const override { return analyses::POINTED_LOCALS; }
+
+        bool run(ir::Function& function, AnalysisCache& cache) override {
+            EmptyBlockEliminationVisitor emptyBlockElimination{cache.dependanceMap()};
+            emptyBlockElimination.visit(function);
+            return emptyBlockElimination.changed();
+        }
+    };
+
+    class BlockReorderingPass : public Pass {
+      public:
+        std::string_view name() const override { return "reorder"; }
+        // Unreachable blocks are deleted and the block indices change
+        AnalysisSet preserved() const override { return analyses::POINTED_LOCALS; }
+
+        bool run(ir::Function& function, AnalysisCache&) override {
+            BlockReorderingVisitor blockReordering;
+            blockReordering.visit(function);
+            return blockReordering.changed();
+        }
+    };
+
+    struct PassEntry {
+        std::string_view name;
+        std::unique_ptr<Pass> (*create)();
+    };
+
+    template <class PassT>
+    std::unique_ptr<Pass> createPass() {
+        return std::make_unique<PassT>();
+    }
+
+    // Every pass usable with -passes=, in the order of the default pipeline
+    constexpr PassEntry PASSES[] = {
+        {"propagate", createPass<ValuePropagationPass>},
+        {"dce", createPass<DeadCodeEliminationPass>},
+        {"fold", createPass<ConstantFoldingPass>},
+        {"two-step", createPass<TwoStepAssignmentEliminationPass>},
+        {"empty-blocks", createPass<EmptyBlockEliminationPass>},
+        {"reorder", createPass<BlockReorderingPass>},
+    };
+}
+
+PassManager PassManager::defaultPipeline() {
+    PassManager manager;
+    for (const auto& entry : PASSES) {
+        manager.addPass(entry.create());
+    }
+    return manager;
+}
+
+std::optional<PassManager> PassManager::parse(std::string_view passes, std::ostream& log) {
+    PassManager manager;
+    while (!passes.empty()) {
+        size_t comma = passes.find(',');
+        std::string_view name = passes.substr(0, comma);
+        passes = comma == std::string_view::npos ? std::string_view{} : passes.substr(comma + 1);
+
+        if (name.empty())
+            continue;
+
+        auto it = std::find_if(std::begin(PASSES), std::end(PASSES), [name](const auto& entry) {
+            return entry.name == name;
+        });
+        if (it == std::end(PASSES)) {
+            log << "error: unknown pass '" << name << "', available passes are:";
+            for (const auto& entry : PASSES) {
+                log << " " << entry.name;
+            }
+            log << std::endl;
+            return std::nullopt;
+        }
+
+        manager.addPass(it->create());
+    }
+
+    return manager;
+}
+
@@ -0,0 +1,78 @@
+#pragma once
+
+#include "BlockDependance.h"
+#include "BlockLivenessAnalysis.h"
+#include "CompileReport.h"
+#include "PointedLocalGatherer.h"
+#include "ir/Ir.h"
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <ostream>
+#include <string_view>
+#include <vector>
+
+// Analyses cached by the AnalysisCache, combined as a bit mask to describe what a pass preserves
+using AnalysisSet = uint32_t;
+
+namespace analyses {
+    constexpr AnalysisSet NONE = 0;
+    constexpr AnalysisSet POINTED_LOCALS = 1 << 0;
+    constexpr AnalysisSet DEPENDANCE_MAP = 1 << 1;
+    constexpr AnalysisSet LIVENESS = 1 << 2;
+    constexpr AnalysisSet ALL = POINTED_LOCALS | DEPENDANCE_MAP | LIVENESS;
+}
+
+// Lazily computes the analyses of a function and keeps them until they are invalidated
+class AnalysisCache {
+  public:
+    explicit AnalysisCache(ir::Function& function) : m_function(function) {}
+
+    PointedLocals& pointedLocals();
+    DependanceMap& dependanceMap();
+    BlockLivenessAnalysis& liveness();
+
+    // Drop every analysis not in preserved
+    void invalidate(AnalysisSet preserved);
+
+  private:
+    ir::Function& m_function;
+
+    std::optional<PointedLocals> m_pointedLocals;
+    std::optional<DependanceMap> m_dependanceMap;
+    std::optional<BlockLivenessAnalysis> m_liveness;
+};
+
+class Pass {
+  public:
+    virtual ~Pass() = default;
+
+    // Name used to select the pass with -passes=
+    virtual std::string_view name() const = 0;
+
+    // Analyses still valid after the pass changed the function
+    virtual AnalysisSet preserved() const = 0;
+
+    // Run the pass on the function, return true if it changed something
+    virtual bool run(ir::Function& function, AnalysisCache& cache) = 0;
+};
+
+// Runs a pipeline of passes on a function until none of them changes it anymore.
+// Passes keep no state between two runs so the same PassManager can run on several functions at once.
+class PassManager {
+  public:
+    void addPass(std::unique_ptr<Pass> pass) { m_passes.push_back(std::move(pass)); }
+
+    // Each pass run is measured in report when it is not null
+    void run(ir::Function& function, CompileReport* report = nullptr);
+
+    // Pipeline used when no -passes= option is given
+    static PassManager defaultPipeline();
+
+    // Build a pipeline from a comma separated list of pass names, for example "propagate,dce,fold".
+    // Return nullopt and print an error to log if a pass does not exist
+    static std::optional<PassManager> parse(std::string_view passes, std::ostream& log);
+
+  private:
+    std::vector<std::unique_ptr<Pass>> m_passes;
+};
@@ -1,61 +1,95 @@
 #include "RegisterAllocation.h"
-#include <ranges>
-#include <set>
+#include <bit>
+#include <stdexcept>
 
 RegisterAllocationResult computeRegisterAllocation(
     const ir::Function& function, const PointedLocals& pointedLocals, const InterferenceGraph& interferenceGraph,
     uint32_t registerCount
 ) {
-    constexpr uint32_t minRegister = 0;
-    auto range = std::ranges::iota_view(minRegister, registerCount);
-    const std::set<LocalId> possibleRegisters{range.begin(), range.end()} ;
+    if (registerCount > 64) {
+        throw std::runtime_error("Register allocation supports at most 64 registers");
+    }
 
     RegisterAllocationResult result{pointedLocals};
-    std::vector<LocalId> removedVertexStack;
+    size_t localCount = interferenceGraph.localCount();
 
-    auto isInGraph = [&](LocalId local) {
-        return !result.m_spilled.contains(local) &&
-            std::ranges::find(removedVertexStack, local) == removedVertexStack.end();
-    };
-
-    bool found = true;
-    while (found) {
-        found = false;
-        LocalId minLocal;
-        size_t minNeighbors = 0;
-        for (LocalId local = 0; local < interferenceGraph.localCount(); local++) {
-            if (!isInGraph(local))
-                continue;
+    // Pointed locals live on the stack so they are never in the graph
+    std::vector<bool> removed(localCount, false);
+    for (auto local : result.m_spilled) {
+        removed[local] = true;
+    }
 
-            size_t neighbors = std::ranges::count_if(interferenceGraph.neighbors(local), isInGraph);
-            if (!found || minNeighbors < neighbors) {
-                minNeighbors = neighbors;
-                minLocal = local;
-                found = true;
-            }
+    // Number of neighbors still in the graph
+    std::vector<uint32_t> degrees(localCount, 0);
+    for (LocalId local = 0; local < localCount; local++) {
+        if (removed[local])
+            continue;
+        for (auto neighbor : interferenceGraph.neighbors(local)) {
+            degrees[local] += !removed[neighbor];
         }
+    }
 
-        if (found) {
-            removedVertexStack.push_back(minLocal);
+    // buckets[d] contains the locals of degree d. A local is not moved out of its bucket when its degree
+    // decreases, it is pushed in the new one and stale entries are skipped when popped.
+    std::vector<std::vector<LocalId>> buckets;
+    for (LocalId local = 0; local < localCount; local++) {
+        if (removed[local])
+            continue;
+        if (degrees[local] >= buckets.size()) {
+            buckets.resize(degrees[local] + 1);
+        }
+        buckets[degrees[local]].push_back(local);
+    }
+
+    // Simplify : always remove the local with the fewest neighbors left.
+    // The degree of a neighbor only drops by one at each removal so the minimum bucket can only go back by one.
+    std::vector<LocalId> removedVertexStack;
+    size_t minDegree = 0;
+    while (minDegree < buckets.size()) {
+        if (buckets[minDegree].empty()) {
+            minDegree++;
+            continue;
+        }
+
+        LocalId local = buckets[minDegree].back();
+        buckets[minDegree].pop_back();
+        if (removed[local] || degrees[local] != minDegree)
+            continue;
+
+        removed[local] = true;
+        removedVertexStack.push_back(local);
+        for (auto neighbor : interferenceGraph.neighbors(local)) {
+            if (removed[neighbor])
+                continue;
+            degrees[neighbor]--;
+            buckets[degrees[neighbor]].push_back(neighbor);
+            if (degrees[neighbor] < minDegree) {
+                minDegree = degrees[neighbor];
+            }
         }
     }
 
+    // Select : color the locals in the reverse order of their removal
+    constexpr uint32_t NO_REGISTER = UINT32_MAX;
+    std::vector<uint32_t> colors(localCount, NO_REGISTER);
+    uint64_t allRegisters = registerCount == 64 ? ~uint64_t(0) : (uint64_t(1) << registerCount) - 1;
     while (!removedVertexStack.empty()) {
         LocalId local = removedVertexStack.back();
         removedVertexStack.pop_back();
 
-        std::set<LocalId> possibleColors = possibleRegisters;
+        uint64_t usedColors = 0;
         for (auto neighbor : interferenceGraph.neighbors(local)) {
-            auto it = result.m_registers.find(neighbor);
-            if (it != result.m_registers.end()) {
-                possibleColors.erase(it->second);
+            if (colors[neighbor] != NO_REGISTER) {
+                usedColors |= uint64_t(1) << colors[neighbor];
             }
         }
 
-        if (possibleColors.empty()) {
+        uint64_t possibleColors = allRegisters & ~usedColors;
+        if (possibleColors == 0) {
             result.m_spilled.insert(local);
         } else {
-            result.m_registers.insert({local, *possibleColors.begin()});
+            colors[local] = std::countr_zero(possibleColors);
+            result.m_registers.insert({local, colors[local]});
         }
     }
 
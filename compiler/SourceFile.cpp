@@ -0,0 +1,126 @@
+#include "SourceFile.h"
+
+#include <cerrno>
+#include <fcntl.h>
+#include <stdexcept>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <utility>
+
+std::optional<SourceFile> SourceFile::open(const std::string& path) {
+    if (path == "-") {
+        SourceFile source("<stdin>");
+        char chunk[64 * 1024];
+        ssize_t count;
+        while ((count = read(STDIN_FILENO, chunk, sizeof(chunk))) != 0) {
+            if (count < 0) {
+                if (errno == EINTR)
+                    continue;
+                return std::nullopt;
+            }
+            source.m_buffer.append(chunk, count);
+        }
+        return source;
+    }
+
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        return std::nullopt;
+    }
+
+    struct stat info;
+    if (fstat(fd, &info) < 0 || S_ISDIR(info.st_mode)) {
+        close(fd);
+        return std::nullopt;
+    }
+
+    SourceFile source(path);
+    // Pipes and other special files cannot be mapped, and mapping an empty file fails
+    void* mapping = MAP_FAILED;
+    if (S_ISREG(info.st_mode) && info.st_size > 0) {
+        mapping = mmap(nullptr, info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    }
+
+    if (mapping != MAP_FAILED) {
+        // The lexer reads the file once from start to end
+        madvise(mapping, info.st_size, MADV_SEQUENTIAL);
+        source.m_mapped = static_cast<const char*>(mapping);
+        source.m_size = info.st_size;
+    } else {
+        char chunk[64 * 1024];
+        ssize_t count;
+        while ((count = read(fd, chunk, sizeof(chunk))) != 0) {
+            if (count < 0) {
+                if (errno == EINTR)
+                    continue;
+                close(fd);
+                return std::nullopt;
+            }
+            source.m_buffer.append(chunk, count);
+        }
+    }
+
+    // The mapping stays valid after the file is closed
+    close(fd);
+    return source;
+}
+
+SourceFile SourceFile::fromText(std::string name, std::string text) {
+    SourceFile source(std::move(name));
+    source.m_buffer = std::move(text);
+    return source;
+}
+
+SourceFile::SourceFile(SourceFile&& other) noexcept :
+    m_name(std::move(other.m_name)), m_mapped(std::exchange(other.m_mapped, nullptr)),
+    m_size(std::exchange(other.m_size, 0)), m_buffer(std::move(other.m_buffer)) {}
+
+SourceFile& SourceFile::operator=(SourceFile&& other) noexcept {
+    if (this != &other) {
+        if (m_mapped) {
+            munmap(const_cast<char*>(m_mapped), m_size);
+        }
+        m_name = std::move(other.m_name);
+        m_mapped = std::exchange(other.m_mapped, nullptr);
+        m_size = std::exchange(other.m_size, 0);
+        m_buffer = std::move(other.m_buffer);
+    }
+    return *this;
+}
+
+SourceFile::~SourceFile() {
+    if (m_mapped) {
+        munmap(const_cast<char*>(m_mapped), m_size);
+    }
+}
+
+void SourceCharStream::consume() {
+    if (m_position >= m_text.size()) {
+        throw std::runtime_error("cannot consume EOF");
+    }
+    m_position++;
+}
+
+size_t SourceCharStream::LA(ssize_t i) {
+    if (i == 0) {
+        return 0;
+    }
+
+    // LA(-1) is the last consumed character
+    ssize_t position = i > 0 ? ssize_t(m_position) + i - 1 : ssize_t(m_position) + i;
+    if (position < 0 || size_t(position) >= m_text.size()) {
+        return IntStream::EOF;
+    }
+
+    return static_cast<unsigned char>(m_text[position]);
+}
+
+std::string SourceCharStream::getText(const antlr4::misc::Interval& interval) {
+    if (interval.a < 0 || interval.b < interval.a || size_t(interval.a) >= m_text.size()) {
+        return "";
+    }
+
+    size_t stop = std::min<size_t>(interval.b, m_text.size() - 1);
+    return std::string(m_text.substr(interval.a, stop - interval.a + 1));
+}
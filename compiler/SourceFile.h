@@ -0,0 +1,66 @@
+#pragma once
+
+#include "antlr4-runtime.h"
+#include <algorithm>
+#include <cstddef>
+#include <optional>
+#include <string>
+#include <string_view>
+
+// Content of the compiled source file.
+// Regular files are mapped in memory instead of being copied, stdin is read in chunks.
+class SourceFile {
+  public:
+    // Open path, or read stdin when path is "-". Return nullopt if the file cannot be read
+    static std::optional<SourceFile> open(const std::string& path);
+    // Source received by the compile server, it is not read from a file
+    static SourceFile fromText(std::string name, std::string text);
+
+    SourceFile(SourceFile&& other) noexcept;
+    SourceFile& operator=(SourceFile&& other) noexcept;
+    SourceFile(const SourceFile&) = delete;
+    SourceFile& operator=(const SourceFile&) = delete;
+    ~SourceFile();
+
+    std::string_view text() const { return m_mapped ? std::string_view(m_mapped, m_size) : m_buffer; }
+    const std::string& name() const { return m_name; }
+
+  private:
+    SourceFile(std::string name) : m_name(std::move(name)) {}
+
+    std::string m_name;
+    // Memory mapping of the file, null when the content is in m_buffer
+    const char* m_mapped = nullptr;
+    size_t m_size = 0;
+    std::string m_buffer;
+};
+
+// Character stream reading the source text in place, each byte is one character.
+// ANTLRInputStream would convert the whole file to UTF-32 first, the grammar only needs ASCII and
+// the bytes of string literals are copied as they are anyway.
+class SourceCharStream : public antlr4::CharStream {
+  public:
+    SourceCharStream(std::string_view text, std::string name) : m_text(text), m_name(std::move(name)) {}
+
+    void consume() override;
+    size_t LA(ssize_t i) override;
+
+    // The whole text is always available so marks are not needed
+    ssize_t mark() override { return -1; }
+    void release(ssize_t) override {}
+
+    size_t index() override { return m_position; }
+    void seek(size_t index) override { m_position = std::min(index, m_text.size()); }
+    size_t size() override { return m_text.size(); }
+    std::string getSourceName() const override { return m_name; }
+
+    std::string getText(const antlr4::misc::Interval& interval) override;
+    std::string toString() const override { return std::string(m_text); }
+
+    std::string_view text() const { return m_text; }
+
+  private:
+    std::string_view m_text;
+    std::string m_name;
+    size_t m_position = 0;
+};
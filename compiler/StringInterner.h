@@ -0,0 +1,104 @@
+#pragma once
+
+#include <array>
+#include <bit>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <shared_mutex>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <utility>
+
+// Dense id of an interned string
+using Symbol = uint32_t;
+
+// Gives a dense id to each distinct string, so the strings can index vectors instead of hash tables.
+// It can be used from several threads: the ids are given under a lock, but text() never locks.
+class StringInterner {
+  public:
+    static constexpr Symbol NONE = UINT32_MAX;
+
+    Symbol intern(std::string_view text) {
+        {
+            std::shared_lock lock(m_mutex);
+            auto it = m_ids.find(text);
+            if (it != m_ids.end()) {
+                return it->second;
+            }
+        }
+
+        std::unique_lock lock(m_mutex);
+        // Another thread may have interned it while the lock was released
+        auto it = m_ids.find(text);
+        if (it != m_ids.end()) {
+            return it->second;
+        }
+
+        if (m_frozen) {
+            throw std::runtime_error("Cannot intern " + std::string(text) + " : the interner is frozen");
+        }
+
+        Symbol id = m_size;
+        auto [segment, offset] = position(id);
+        if (segment >= m_segments.size()) {
+            throw std::runtime_error("Too many strings");
+        }
+        if (!m_segments[segment]) {
+            m_segments[segment] = std::make_unique<std::string[]>(FIRST_SEGMENT_SIZE << segment);
+        }
+
+        std::string& stored = m_segments[segment][offset];
+        stored = text;
+        m_ids.emplace(stored, id);
+        m_size++;
+        return id;
+    }
+
+    // Return NONE if the string has never been interned
+    Symbol find(std::string_view text) const {
+        std::shared_lock lock(m_mutex);
+        auto it = m_ids.find(text);
+        return it != m_ids.end() ? it->second : NONE;
+    }
+
+    const std::string& text(Symbol id) const {
+        auto [segment, offset] = position(id);
+        return m_segments[segment][offset];
+    }
+
+    size_t size() const {
+        std::shared_lock lock(m_mutex);
+        return m_size;
+    }
+
+    // Forbid the interning of new strings, to check that a phase only reads the interner
+    void freeze() { m_frozen = true; }
+
+    bool frozen() const { return m_frozen; }
+
+  private:
+    static constexpr size_t FIRST_SEGMENT_SIZE = 64;
+
+    // The strings are stored in segments of doubling size which are never moved, so text() can read a string
+    // while another thread interns a new one. The keys of m_ids point into them too
+    std::array<std::unique_ptr<std::string[]>, 26> m_segments;
+    size_t m_size = 0;
+    std::unordered_map<std::string_view, Symbol> m_ids;
+    mutable std::shared_mutex m_mutex;
+    bool m_frozen = false;
+
+    // Segment of a string and its index in the segment
+    static std::pair<size_t, size_t> position(Symbol id) {
+        size_t shifted = size_t(id) + FIRST_SEGMENT_SIZE;
+        size_t segment = std::bit_width(shifted) - std::bit_width(FIRST_SEGMENT_SIZE);
+        return {segment, shifted - (FIRST_SEGMENT_SIZE << segment)};
+    }
+};
+
+// Names of the functions of the program. The IR only keeps their Symbol, the text is looked up when printing.
+// It is shared by every file compiled by the process, the names of the variables are interned per file by
+// IrSymbolTable
+inline StringInterner globalSymbols;
@@ -48,8 +48,8 @@ class TwoStepAssignmentEliminationVisitor : public ir::Visitor {
   private:
     LiveSet m_workingSet;
     BlockLivenessAnalysis& m_livenessAnalysis;
-    std::unordered_map<ir::Local, std::pair<ir::Local, std::unique_ptr<ir::Instruction>*>> m_potentialTarget;
-    std::unique_ptr<ir::Instruction>* m_currentInstruction;
+    std::unordered_map<ir::Local, std::pair<ir::Local, ir::Instruction**>> m_potentialTarget;
+    ir::Instruction** m_currentInstruction;
     PointedLocals& m_pointedLocals;
     bool m_changed = false;
 };
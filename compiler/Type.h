@@ -1,23 +1,42 @@
 #pragma once
 
+#include <array>
+#include <atomic>
+#include <bit>
+#include <cstdint>
+#include <deque>
 #include <iostream>
+#include <mutex>
 #include <stdexcept>
-#include <unordered_map>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// Dense index of a type in the TypePool
+using TypeId = uint16_t;
 
 class Type {
   public:
-    Type(std::string name, size_t size) : m_size(size), m_target(nullptr), m_name(std::move(name)) {}
-    Type(std::string name, const Type* target) : m_size(8), m_target(target), m_name(std::move(name)) {}
-
     bool isPtr() const { return m_target != nullptr; }
     size_t size() const { return m_size; }
+    // log2 of the size, every type except void has a power of two size. 0 for void
+    uint8_t sizeLog2() const { return m_sizeLog2; }
     auto target() const { return m_target; }
+    TypeId id() const { return m_id; }
     const auto& name() const { return m_name; }
 
   private:
+    Type(TypeId id, std::string name, size_t size, const Type* target) :
+        m_size(size), m_sizeLog2(size ? std::countr_zero(size) : 0), m_id(id), m_target(target),
+        m_name(std::move(name)) {}
+
     size_t m_size;
+    uint8_t m_sizeLog2;
+    TypeId m_id;
     const Type* m_target;
     std::string m_name;
+
+    friend class TypePool;
 };
 
 namespace types {
@@ -29,42 +48,85 @@ namespace types {
     inline Type* VOID;
 }
 
+// Every type of the program, indexed by TypeId. The simple types come first, in the order of init.
+// The pool is shared by every file compiled by the process: existing types are found without locking and
+// only the creation of a pointer type takes the lock.
 class TypePool {
   public:
     void init() {
-        types::INT = &m_simpleTypes.insert({"int", Type("int", 4)}).first->second;
-        types::CHAR = &m_simpleTypes.insert({"char", Type("char", 1)}).first->second;
-        types::BOOL = &m_simpleTypes.insert({"bool", Type("bool", 1)}).first->second;
-        types::LONG = &m_simpleTypes.insert({"long", Type("long", 8)}).first->second;
-        types::SHORT = &m_simpleTypes.insert({"short", Type("short", 2)}).first->second;
-        types::VOID = &m_simpleTypes.insert({"void", Type("void", size_t(0))}).first->second;
+        types::INT = &add("int", 4, nullptr);
+        types::CHAR = &add("char", 1, nullptr);
+        types::BOOL = &add("bool", 1, nullptr);
+        types::LONG = &add("long", 8, nullptr);
+        types::SHORT = &add("short", 2, nullptr);
+        types::VOID = &add("void", 0, nullptr);
+        for (const Type& type : m_types) {
+            m_simpleTypes.push_back(&type);
+        }
     }
 
+    // Forbid the creation of new types, to check that a phase only reads the pool
+    void freeze() { m_frozen = true; }
+
+    bool frozen() const { return m_frozen; }
+
   private:
-    std::unordered_map<std::string, Type> m_simpleTypes;
-    std::unordered_map<const Type*, Type> m_pointerTypes;
+    // A deque never moves its elements, types are referenced by pointer
+    std::deque<Type> m_types;
+    // Never modified after init, so it is read without locking
+    std::vector<const Type*> m_simpleTypes;
+    // Pointer type to each type, null when it has not been created. Read without locking, written under
+    // m_mutex. The pages of the ids never used are never touched
+    std::array<std::atomic<const Type*>, size_t(UINT16_MAX) + 1> m_pointers{};
+    mutable std::mutex m_mutex;
+    bool m_frozen = false;
+
+    // Called with m_mutex held, or before the pool is shared
+    Type& add(std::string name, size_t size, const Type* target) {
+        if (m_types.size() > UINT16_MAX) {
+            throw std::runtime_error("Too many types");
+        }
 
-    friend const Type* make_simple_type(const std::string& name);
+        return m_types.emplace_back(Type(m_types.size(), std::move(name), size, target));
+    }
+
+    friend const Type* make_simple_type(std::string_view name);
     friend const Type* make_pointer_type(const Type* target);
 };
 
 inline TypePool globalTypePool;
 
-inline const Type* make_simple_type(const std::string& name) {
-    auto it = globalTypePool.m_simpleTypes.find(name);
-    if (it == globalTypePool.m_simpleTypes.end()) {
-        throw std::runtime_error("Unknown type");
+inline const Type* make_simple_type(std::string_view name) {
+    // Only a handful of simple types, comparing the names is cheaper than hashing them
+    for (const Type* type : globalTypePool.m_simpleTypes) {
+        if (type->name() == name) {
+            return type;
+        }
     }
 
-    return &it->second;
+    throw std::runtime_error("Unknown type");
 }
 
 inline const Type* make_pointer_type(const Type* type) {
-    auto it = globalTypePool.m_pointerTypes.find(type);
-    if (it != globalTypePool.m_pointerTypes.end()) {
-        return &it->second;
+    auto& slot = globalTypePool.m_pointers[type->id()];
+    const Type* pointer = slot.load(std::memory_order_acquire);
+    if (pointer) {
+        return pointer;
+    }
+
+    std::lock_guard lock(globalTypePool.m_mutex);
+    // Another thread may have created it while we were waiting for the lock
+    pointer = slot.load(std::memory_order_relaxed);
+    if (pointer) {
+        return pointer;
     }
 
     std::string name = type->name() + "*";
-    return &globalTypePool.m_pointerTypes.insert({type, Type(std::move(name), type)}).first->second;
+    if (globalTypePool.m_frozen) {
+        throw std::runtime_error("Cannot create type " + name + " : the type pool is frozen");
+    }
+
+    pointer = &globalTypePool.add(std::move(name), 8, type);
+    slot.store(pointer, std::memory_order_release);
+    return pointer;
 }
@@ -0,0 +1,416 @@
+#include "X86Encoder.h"
+
+#include <cstdint>
+#include <initializer_list>
+#include <optional>
+#include <stdexcept>
+#include <variant>
+
+namespace {
+    // Number of each register in the encoding, Register follows another order
+    constexpr uint8_t REGISTER_NUMBER[16] = {0, 3, 1, 2, 6, 7, 4, 5, 8, 9, 10, 11, 12, 13, 14, 15};
+
+    // Bits of the REX prefix extending the reg field and the rm field of the ModRM byte
+    constexpr uint8_t REX_R = 0x4;
+    constexpr uint8_t REX_B = 0x1;
+
+    constexpr uint32_t NO_LABEL = UINT32_MAX;
+
+    uint8_t number(Register reg) { return REGISTER_NUMBER[uint8_t(reg)]; }
+
+    // spl, bpl, sil and dil need a REX prefix, without one the same numbers are ah, ch, dh and bh
+    bool needsRex(SizedRegister reg) { return reg.size == 1 && number(reg.reg) >= 4 && number(reg.reg) < 8; }
+
+    uint8_t conditionNumber(ConditionCode condition) {
+        switch (condition) {
+            case ConditionCode::E:
+            case ConditionCode::Z: return 0x4;
+            case ConditionCode::NE: return 0x5;
+            case ConditionCode::L: return 0xC;
+            case ConditionCode::GE: return 0xD;
+            case ConditionCode::LE: return 0xE;
+            case ConditionCode::G: return 0xF;
+        }
+
+        throw std::runtime_error("Unknown condition");
+    }
+
+    bool fitsInt8(int64_t value) { return value >= INT8_MIN && value <= INT8_MAX; }
+    bool fitsInt32(int64_t value) { return value >= INT32_MIN && value <= INT32_MAX; }
+
+    bool isJump(const MachineInstruction& instruction) {
+        return instruction.opcode == X86Opcode::J || instruction.opcode == X86Opcode::JMP;
+    }
+
+    SizedRegister registerOperand(const Operand& operand) {
+        if (!std::holds_alternative<SizedRegister>(operand)) {
+            throw std::runtime_error("Expected a register operand");
+        }
+        return std::get<SizedRegister>(operand);
+    }
+
+    // Immediates are at most 4 bytes, sign extended by the processor for 8 byte instructions
+    size_t immediateSize(size_t size) { return size == 8 ? 4 : size; }
+
+    // Value of an immediate operand sign extended from the size of the instruction
+    int64_t immediateValue(const ImmediateOperand& immediate, size_t size) {
+        switch (size) {
+            case 1: return int8_t(immediate.value);
+            case 2: return int16_t(immediate.value);
+            case 4: return int32_t(immediate.value);
+            default:
+                if (!fitsInt32(immediate.value)) {
+                    throw std::runtime_error("Immediate does not fit in 32 bits");
+                }
+                return immediate.value;
+        }
+    }
+
+    // Appends the encoding of every instruction but the jumps to a MachineCode
+    class Encoder {
+      public:
+        explicit Encoder(MachineCode& code) : m_code(code) {}
+
+        void encode(const MachineInstruction& instruction);
+
+      private:
+        MachineCode& m_code;
+
+        void byte(uint8_t value) { m_code.bytes.push_back(value); }
+
+        // Little endian value truncated to size bytes
+        void immediate(int64_t value, size_t size) {
+            for (size_t i = 0; i < size; i++) {
+                byte(uint8_t(value >> (8 * i)));
+            }
+        }
+
+        // Operand size prefix and REX prefix of an instruction whose operands have the given size (0 for none)
+        void prefixes(size_t size, uint8_t rexBits, bool forceRex) {
+            if (size == 2) {
+                byte(0x66);
+            }
+            uint8_t rex = rexBits | (size == 8 ? 0x8 : 0);
+            if (rex != 0 || forceRex) {
+                byte(0x40 | rex);
+            }
+        }
+
+        // Instruction with a ModRM byte. reg is a register number or the extension of the opcode, rm a register or
+        // a memory operand. regRex is true when reg is a byte register which needs a REX prefix. immediateBytes is
+        // the size of the immediate the caller appends after, rip relative addresses are relative to its end
+        void withModRM(
+            size_t size, std::initializer_list<uint8_t> opcode, uint8_t reg, bool regRex, const Operand& rm,
+            size_t immediateBytes = 0
+        );
+
+        void mov(size_t size, const Operand& source, const Operand& destination);
+        // ADD, OR, AND, SUB, XOR and CMP only differ by their extension
+        void arithmetic(uint8_t extension, size_t size, const Operand& source, const Operand& destination);
+        void imul(size_t size, const Operand& source, const Operand& destination);
+        void shl(size_t size, const Operand& source, const Operand& destination);
+    };
+
+    void Encoder::withModRM(
+        size_t size, std::initializer_list<uint8_t> opcode, uint8_t reg, bool regRex, const Operand& rm,
+        size_t immediateBytes
+    ) {
+        uint8_t rexBits = reg & 0x8 ? REX_R : 0;
+        bool forceRex = regRex;
+
+        // Base register of a memory operand, or the register operand
+        std::optional<uint8_t> base;
+        int32_t offset = 0;
+        bool memory = true;
+        if (auto* operand = std::get_if<SizedRegister>(&rm)) {
+            base = number(operand->reg);
+            forceRex |= needsRex(*operand);
+            memory = false;
+        } else if (auto* operand = std::get_if<Deref>(&rm)) {
+            base = number(operand->reg.reg);
+        } else if (auto* operand = std::get_if<DerefOffset>(&rm)) {
+            base = number(operand->reg.reg);
+            offset = operand->offset;
+        } else if (!std::holds_alternative<DataLabel>(rm)) {
+            throw std::runtime_error("Invalid operand");
+        }
+        if (base && *base & 0x8) {
+            rexBits |= REX_B;
+        }
+
+        prefixes(size, rexBits, forceRex);
+        for (uint8_t value : opcode) {
+            byte(value);
+        }
+
+        uint8_t regField = (reg & 0x7) << 3;
+        if (!memory) {
+            byte(0xC0 | regField | (*base & 0x7));
+        } else if (!base) {
+            // rip relative address of a literal, filled by the linker
+            byte(0x05 | regField);
+            uint32_t relocationOffset = m_code.bytes.size();
+            int32_t addend = -int32_t(4 + immediateBytes);
+            m_code.relocations.push_back(
+                {CodeRelocation::Kind::LITERAL, relocationOffset, std::get<DataLabel>(rm).literal, addend}
+            );
+            immediate(0, 4);
+        } else {
+            // rbp and r13 without a displacement encode a rip relative address, they get a displacement of 0
+            uint8_t mod = offset == 0 && (*base & 0x7) != 5 ? 0x00 : fitsInt8(offset) ? 0x40 : 0x80;
+            byte(mod | regField | (*base & 0x7));
+            // rsp and r12 in rm introduce a SIB byte, which names them again as a base without index
+            if ((*base & 0x7) == 4) {
+                byte(0x24);
+            }
+            if (mod == 0x40) {
+                immediate(offset, 1);
+            } else if (mod == 0x80) {
+                immediate(offset, 4);
+            }
+        }
+    }
+
+    void Encoder::mov(size_t size, const Operand& source, const Operand& destination) {
+        if (auto* reg = std::get_if<SizedRegister>(&source)) {
+            withModRM(size, {uint8_t(size == 1 ? 0x88 : 0x89)}, number(reg->reg), needsRex(*reg), destination);
+        } else if (auto* value = std::get_if<ImmediateOperand>(&source)) {
+            auto* reg = std::get_if<SizedRegister>(&destination);
+            if (reg && (size != 8 || !fitsInt32(value->value))) {
+                // The register is in the opcode and the immediate has the full size of the register (movabs for 8
+                // bytes)
+                prefixes(size, number(reg->reg) & 0x8 ? REX_B : 0, needsRex(*reg));
+                byte((size == 1 ? 0xB0 : 0xB8) | (number(reg->reg) & 0x7));
+                immediate(value->value, size);
+            } else {
+                int64_t extended = immediateValue(*value, size);
+                withModRM(size, {uint8_t(size == 1 ? 0xC6 : 0xC7)}, 0, false, destination, immediateSize(size));
+                immediate(extended, immediateSize(size));
+            }
+        } else {
+            SizedRegister reg = registerOperand(destination);
+            withModRM(size, {uint8_t(size == 1 ? 0x8A : 0x8B)}, number(reg.reg), needsRex(reg), source);
+        }
+    }
+
+    void Encoder::arithmetic(uint8_t extension, size_t size, const Operand& source, const Operand& destination) {
+        // The opcodes of the register forms are 8 times the extension
+        uint8_t opcode = (extension << 3) | (size == 1 ? 0 : 1);
+        if (auto* reg = std::get_if<SizedRegister>(&source)) {
+            withModRM(size, {opcode}, number(reg->reg), needsRex(*reg), destination);
+        } else if (auto* value = std::get_if<ImmediateOperand>(&source)) {
+            int64_t extended = immediateValue(*value, size);
+            auto* reg = std::get_if<SizedRegister>(&destination);
+            if (reg && reg->reg == Register::RAX && (size == 1 || !fitsInt8(extended))) {
+                // Short form of the accumulator, without ModRM
+                prefixes(size, 0, false);
+                byte((extension << 3) | (size == 1 ? 0x4 : 0x5));
+                immediate(extended, immediateSize(size));
+            } else if (size == 1) {
+                withModRM(size, {0x80}, extension, false, destination, 1);
+                immediate(extended, 1);
+            } else if (fitsInt8(extended)) {
+                withModRM(size, {0x83}, extension, false, destination, 1);
+                immediate(extended, 1);
+            } else {
+                withModRM(size, {0x81}, extension, false, destination, immediateSize(size));
+                immediate(extended, immediateSize(size));
+            }
+        } else {
+            SizedRegister reg = registerOperand(destination);
+            withModRM(size, {uint8_t(opcode | 0x2)}, number(reg.reg), needsRex(reg), source);
+        }
+    }
+
+    void Encoder::imul(size_t size, const Operand& source, const Operand& destination) {
+        if (size == 1) {
+            throw std::runtime_error("imul has no 1 byte form with two operands");
+        }
+
+        SizedRegister reg = registerOperand(destination);
+        if (auto* value = std::get_if<ImmediateOperand>(&source)) {
+            // Three operand form, the register is multiplied into itself
+            int64_t extended = immediateValue(*value, size);
+            size_t bytes = fitsInt8(extended) ? 1 : immediateSize(size);
+            withModRM(size, {uint8_t(bytes == 1 ? 0x6B : 0x69)}, number(reg.reg), false, destination, bytes);
+            immediate(extended, bytes);
+        } else {
+            withModRM(size, {0x0F, 0xAF}, number(reg.reg), false, source);
+        }
+    }
+
+    void Encoder::shl(size_t size, const Operand& source, const Operand& destination) {
+        auto* count = std::get_if<ImmediateOperand>(&source);
+        if (!count) {
+            throw std::runtime_error("shl is only emitted with an immediate count");
+        }
+
+        // Like the assembler, a shift by 1 uses the form without immediate
+        if (count->value == 1) {
+            withModRM(size, {uint8_t(size == 1 ? 0xD0 : 0xD1)}, 4, false, destination);
+        } else {
+            withModRM(size, {uint8_t(size == 1 ? 0xC0 : 0xC1)}, 4, false, destination, 1);
+            immediate(count->value, 1);
+        }
+    }
+
+    void Encoder::encode(const MachineInstruction& instruction) {
+        size_t size = instruction.size;
+        const auto& operands = instruction.operands;
+        switch (instruction.opcode) {
+            case X86Opcode::MOV: mov(size, operands[0], operands[1]); break;
+            case X86Opcode::MOVS: {
+                SizedRegister reg = registerOperand(operands[1]);
+                switch (instruction.sourceSize) {
+                    case 1: withModRM(size, {0x0F, 0xBE}, number(reg.reg), false, operands[0]); break;
+                    case 2: withModRM(size, {0x0F, 0xBF}, number(reg.reg), false, operands[0]); break;
+                    case 4: withModRM(size, {0x63}, number(reg.reg), false, operands[0]); break;
+                    default: throw std::runtime_error("Unsupported size");
+                }
+            } break;
+            case X86Opcode::LEA:
+                withModRM(size, {0x8D}, number(registerOperand(operands[1]).reg), false, operands[0]);
+                break;
+            case X86Opcode::ADD: arithmetic(0, size, operands[0], operands[1]); break;
+            case X86Opcode::OR: arithmetic(1, size, operands[0], operands[1]); break;
+            case X86Opcode::AND: arithmetic(4, size, operands[0], operands[1]); break;
+            case X86Opcode::SUB: arithmetic(5, size, operands[0], operands[1]); break;
+            case X86Opcode::XOR: arithmetic(6, size, operands[0], operands[1]); break;
+            case X86Opcode::CMP: arithmetic(7, size, operands[0], operands[1]); break;
+            case X86Opcode::IMUL: imul(size, operands[0], operands[1]); break;
+            case X86Opcode::SHL: shl(size, operands[0], operands[1]); break;
+            case X86Opcode::NEG: withModRM(size, {uint8_t(size == 1 ? 0xF6 : 0xF7)}, 3, false, operands[0]); break;
+            case X86Opcode::IDIV: withModRM(size, {uint8_t(size == 1 ? 0xF6 : 0xF7)}, 7, false, operands[0]); break;
+            case X86Opcode::TEST: {
+                // Emitted without a suffix, the size is the one of the registers
+                SizedRegister reg = registerOperand(operands[0]);
+                size_t testSize = size != 0 ? size : reg.size;
+                uint8_t opcode = testSize == 1 ? 0x84 : 0x85;
+                withModRM(testSize, {opcode}, number(reg.reg), needsRex(reg), operands[1]);
+            } break;
+            case X86Opcode::SIGN_EXTEND_ACCUMULATOR:
+                switch (size) {
+                    case 8: byte(0x48); byte(0x99); break;
+                    case 4: byte(0x99); break;
+                    case 2: byte(0x66); byte(0x99); break;
+                    case 1: byte(0x66); byte(0x98); break;
+                    default: throw std::runtime_error("Unsupported size");
+                }
+                break;
+            case X86Opcode::SET:
+                withModRM(1, {0x0F, uint8_t(0x90 | conditionNumber(instruction.condition))}, 0, false, operands[0]);
+                break;
+            case X86Opcode::PUSH:
+            case X86Opcode::POP: {
+                // Always 8 bytes, without REX.W
+                SizedRegister reg = registerOperand(operands[0]);
+                prefixes(0, number(reg.reg) & 0x8 ? REX_B : 0, false);
+                byte((instruction.opcode == X86Opcode::PUSH ? 0x50 : 0x58) | (number(reg.reg) & 0x7));
+            } break;
+            case X86Opcode::CALL: {
+                byte(0xE8);
+                Symbol function = std::get<FunctionLabel>(operands[0]).function;
+                m_code.relocations.push_back({CodeRelocation::Kind::CALL, uint32_t(m_code.bytes.size()), function, -4});
+                immediate(0, 4);
+            } break;
+            case X86Opcode::RET: byte(0xC3); break;
+            case X86Opcode::LABEL:
+            case X86Opcode::J:
+            case X86Opcode::JMP: throw std::runtime_error("Labels and jumps are placed by encodeFunction");
+        }
+    }
+}
+
+MachineCode encodeFunction(Symbol function, const std::vector<MachineInstruction>& instructions) {
+    size_t count = instructions.size();
+
+    // Every instruction but the jumps is encoded once, their bytes are moved to their final address afterwards
+    MachineCode encoded{function};
+    Encoder encoder(encoded);
+    std::vector<uint32_t> encodedStart(count + 1);
+    // Index of the LABEL instruction of each block, by BasicBlock::index()
+    std::vector<uint32_t> labels;
+    for (size_t i = 0; i < count; i++) {
+        encodedStart[i] = encoded.bytes.size();
+        const auto& instruction = instructions[i];
+        if (instruction.opcode == X86Opcode::LABEL) {
+            uint32_t block = std::get<Label>(instruction.operands[0]).block->index();
+            if (block >= labels.size()) {
+                labels.resize(block + 1, NO_LABEL);
+            }
+            labels[block] = i;
+        } else if (!isJump(instruction)) {
+            encoder.encode(instruction);
+        }
+    }
+    encodedStart[count] = encoded.bytes.size();
+
+    auto target = [&](size_t i) {
+        uint32_t block = std::get<Label>(instructions[i].operands[0]).block->index();
+        if (block >= labels.size() || labels[block] == NO_LABEL) {
+            throw std::runtime_error("Jump to a block without label");
+        }
+        return labels[block];
+    };
+
+    // Jumps start with a rel8 and only grow, so the loop ends once no jump has to grow anymore
+    std::vector<bool> near(count, false);
+    std::vector<uint32_t> address(count + 1, 0);
+    bool changed = true;
+    while (changed) {
+        changed = false;
+        for (size_t i = 0; i < count; i++) {
+            uint32_t size = encodedStart[i + 1] - encodedStart[i];
+            if (isJump(instructions[i])) {
+                size = !near[i] ? 2 : instructions[i].opcode == X86Opcode::J ? 6 : 5;
+            }
+            address[i + 1] = address[i] + size;
+        }
+
+        for (size_t i = 0; i < count; i++) {
+            if (isJump(instructions[i]) && !near[i] && !fitsInt8(int64_t(address[target(i)]) - address[i + 1])) {
+                near[i] = true;
+                changed = true;
+            }
+        }
+    }
+
+    MachineCode code{function};
+    code.bytes.reserve(address[count]);
+    size_t relocation = 0;
+    for (size_t i = 0; i < count; i++) {
+        const auto& instruction = instructions[i];
+        if (!isJump(instruction)) {
+            code.bytes.insert(
+                code.bytes.end(), encoded.bytes.begin() + encodedStart[i], encoded.bytes.begin() + encodedStart[i + 1]
+            );
+            for (; relocation < encoded.relocations.size() &&
+                   encoded.relocations[relocation].offset < encodedStart[i + 1];
+                 relocation++) {
+                CodeRelocation moved = encoded.relocations[relocation];
+                moved.offset += address[i] - encodedStart[i];
+                code.relocations.push_back(moved);
+            }
+            continue;
+        }
+
+        int32_t displacement = int64_t(address[target(i)]) - address[i + 1];
+        uint8_t condition = conditionNumber(instruction.condition);
+        if (!near[i]) {
+            code.bytes.push_back(instruction.opcode == X86Opcode::J ? 0x70 | condition : 0xEB);
+            code.bytes.push_back(uint8_t(displacement));
+            continue;
+        }
+
+        if (instruction.opcode == X86Opcode::J) {
+            code.bytes.push_back(0x0F);
+            code.bytes.push_back(0x80 | condition);
+        } else {
+            code.bytes.push_back(0xE9);
+        }
+        for (size_t byte = 0; byte < 4; byte++) {
+            code.bytes.push_back(uint8_t(uint32_t(displacement) >> (8 * byte)));
+        }
+    }
+    return code;
+}
@@ -0,0 +1,35 @@
+#pragma once
+
+#include "MachineInstruction.h"
+#include <cstdint>
+#include <vector>
+
+// Place in the machine code of a function which the linker fills with the address of a symbol
+struct CodeRelocation {
+    enum class Kind : uint8_t {
+        // rel32 of a call, through the PLT
+        CALL,
+        // rel32 of the rip relative address of a string literal
+        LITERAL,
+    };
+
+    Kind kind;
+    // Offset of the rel32 from the start of the function
+    uint32_t offset;
+    // Symbol of the called function, or id of the literal
+    uint32_t target;
+    // Distance from the end of the instruction to the rel32, the value of rip is the end of the instruction
+    int32_t addend;
+};
+
+// Machine code of a function, not yet placed in an object file
+struct MachineCode {
+    Symbol function;
+    std::vector<uint8_t> bytes;
+    std::vector<CodeRelocation> relocations;
+};
+
+// Encode the instructions of a function to x86-64 machine code (-c). Jumps are relaxed: they are all assumed to
+// fit in a rel8 first, and the ones which do not are grown to a rel32 until every jump fits. Throw a
+// std::runtime_error on an instruction which has no encoding, the same ones the assembler would reject
+MachineCode encodeFunction(Symbol function, const std::vector<MachineInstruction>& instructions);
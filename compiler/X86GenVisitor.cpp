@@ -1,11 +1,14 @@
 #include "./X86GenVisitor.h"
 #include "BlockDependance.h"
 #include "BlockLivenessAnalysis.h"
+#include "ElfWriter.h"
 #include "InterferenceGraph.h"
+#include "InterferenceGraphBuilder.h"
 #include "PointedLocalGatherer.h"
 #include "RegisterAllocation.h"
 #include "Type.h"
 #include "ir/Instructions.h"
+#include <chrono>
 #include <fstream>
 #include <set>
 #include <stdexcept>
@@ -78,17 +81,26 @@ void X86GenVisitor::visit(ir::Function& function) {
     // When we are called, there is the return address pushed
     m_stackAlignment = 1;
 
-    PointedLocals pointedLocals = computePointedLocals(function);
-    DependanceMap dependanceMap = computeDependanceMap(function);
-    InterferenceGraph interferenceGraph{function.locals().size()};
-    m_localsUsedThroughCalls.clear();
-    // Compute the interferenceGraph using the block liveness analysis
-    m_livenessAnalysis =
-        computeBlockLivenessAnalysis(function, dependanceMap, &interferenceGraph, &m_localsUsedThroughCalls);
+    PointedLocals pointedLocals;
+    {
+        CompileReport::Scope scope(m_report, "liveness");
+        pointedLocals = computePointedLocals(function);
+        DependanceMap dependanceMap = computeDependanceMap(function);
+        m_localsUsedThroughCalls.clear();
+        m_livenessAnalysis = computeBlockLivenessAnalysis(function, dependanceMap, &m_localsUsedThroughCalls);
+    }
+
+    auto interferenceStart = std::chrono::steady_clock::now();
+    InterferenceGraph interferenceGraph = [&]() {
+        CompileReport::Scope scope(m_report, "interference graph");
+        return computeInterferenceGraph(function, m_livenessAnalysis);
+    }();
+    auto interferenceTime = std::chrono::steady_clock::now() - interferenceStart;
 
 
     std::set<Register> usedRegisters;
     if(m_doRegisterAllocation) {
+        CompileReport::Scope scope(m_report, "register allocation");
         usedRegisters = registerAllocation(function, pointedLocals, interferenceGraph);
     } else {
         size_t stackPos = 8;
@@ -99,50 +111,54 @@ void X86GenVisitor::visit(ir::Function& function) {
         }
     }
 
-    // Used to generate interferenceGraph to debug
-    // std::ofstream debugFile(function.name() + ".ig.dot");
-    // interferenceGraph.printDot(debugFile);
+#ifdef DEBUG_INTERFERENCE_GRAPH
+    // Dump the interferenceGraph and the time spent building it
+    std::ofstream debugFile(function.name() + ".ig.dot");
+    interferenceGraph.printDot(debugFile);
+    std::cerr << function.name() << ": interference graph built in "
+              << std::chrono::duration_cast<std::chrono::microseconds>(interferenceTime).count() << "us" << std::endl;
+#else
+    (void)interferenceTime;
+#endif
 
-    std::cerr << function.name() << ": " << std::endl;
+    if (m_log) {
+        *m_log << function.name() << ": " << std::endl;
+    }
 
     bool needStack = !m_localsOnStack.empty();
 
-    m_out << ".section .text\n";
-    m_out << ".global " << function.name() << "\n";
-    m_out << function.name() << ":\n";
-
     if (needStack) {
-        emit("pushq", SizedRegister(Register::RBP, 8));
+        emit(X86Opcode::PUSH, 8, SizedRegister(Register::RBP, 8));
         m_stackAlignment++;
     }
 
     for (auto reg : usedRegisters) {
         if (preserved(reg)) {
-            emit("pushq", SizedRegister{reg, 8});
+            emit(X86Opcode::PUSH, 8, SizedRegister{reg, 8});
             m_stackAlignment++;
         }
     }
 
     if (needStack) {
-        emit("movq", SizedRegister(Register::RSP, 8), SizedRegister(Register::RBP, 8));
-        emit("subq", Immediate(m_localsOnStack.size() * 8, types::LONG), SizedRegister(Register::RSP, 8));
+        emit(X86Opcode::MOV, 8, SizedRegister(Register::RSP, 8), SizedRegister(Register::RBP, 8));
+        emit(X86Opcode::SUB, 8, Immediate(m_localsOnStack.size() * 8, types::LONG), SizedRegister(Register::RSP, 8));
         m_stackAlignment += m_localsOnStack.size();
     }
 
     for (size_t i = 0; i < function.argCount() && i < ARGS_IN_REGISTER; i++) {
         auto type = function.locals()[i + 1].type();
-        auto suffix = getSuffix(type->size());
+        auto size = type->size();
         SizedRegister reg = {CALL_REGISTER[i], type->size()};
         Local local(i + 1, type);
         if (!m_livenessAnalysis[function.prologue()].first.contains(local)) {
             continue;
         }
-        emit("mov", suffix, reg, local);
+        emit(X86Opcode::MOV, size, reg, local);
     }
 
     for (size_t i = ARGS_IN_REGISTER; i < function.argCount(); i++) {
         auto type = function.locals()[i + 1].type();
-        auto suffix = getSuffix(type->size());
+        auto size = type->size();
         Local local(i + 1, type);
         if (!m_livenessAnalysis[function.prologue()].first.contains(local)) {
             continue;
@@ -150,71 +166,111 @@ void X86GenVisitor::visit(ir::Function& function) {
         auto optionalReg = variableRegister(local);
         DerefOffset argLocation(SizedRegister{Register::RSP, 8}, (i - ARGS_IN_REGISTER + m_stackAlignment) * 8);
         if (optionalReg.has_value()) {
-            emit("mov", suffix, argLocation, SizedRegister(optionalReg.value(), type->size()));
+            emit(X86Opcode::MOV, size, argLocation, SizedRegister(optionalReg.value(), type->size()));
         } else {
             SizedRegister rax(Register::RAX, type->size());
-            emit("mov", suffix, argLocation, rax);
-            emit("mov", suffix, rax, local);
+            emit(X86Opcode::MOV, size, argLocation, rax);
+            emit(X86Opcode::MOV, size, rax, local);
         }
     }
 
     bool adjustAlignment = m_stackAlignment % 2 == 1 && m_localsUsedThroughCalls.size() != 0;
 
     if (adjustAlignment) {
-        emit("pushq", SizedRegister(Register::RCX, 8));
+        emit(X86Opcode::PUSH, 8, SizedRegister(Register::RCX, 8));
         m_stackAlignment++;
     }
 
-    visit(*function.prologue());
-    for (auto& block : function.blocks()) {
-        visit(*block);
+    {
+        CompileReport::Scope scope(m_report, "instruction selection");
+        visit(*function.prologue());
+        for (auto& block : function.blocks()) {
+            visit(*block);
+        }
+        visit(*function.epilogue());
     }
-    visit(*function.epilogue());
 
     if (adjustAlignment) {
-        emit("popq", SizedRegister(Register::RCX, 8));
+        emit(X86Opcode::POP, 8, SizedRegister(Register::RCX, 8));
         m_stackAlignment--;
     }
 
     SizedRegister rax{Register::RAX, function.returnLocal().type()->size()};
     if (function.returnLocal().type()->size() > 0) {
-        auto suffix = getSuffix(function.returnLocal().type()->size());
-        emit("mov", suffix, function.returnLocal(), rax);
+        auto size = function.returnLocal().type()->size();
+        emit(X86Opcode::MOV, size, function.returnLocal(), rax);
     }
 
     if (needStack) {
-        emit("movq", SizedRegister(Register::RBP, 8), SizedRegister(Register::RSP, 8));
+        emit(X86Opcode::MOV, 8, SizedRegister(Register::RBP, 8), SizedRegister(Register::RSP, 8));
     }
 
     for (auto it = usedRegisters.rbegin(); it != usedRegisters.rend(); ++it) {
         if (preserved(*it)) {
-            emit("popq", SizedRegister{*it, 8});
+            emit(X86Opcode::POP, 8, SizedRegister{*it, 8});
             m_stackAlignment--;
         }
     }
     if (needStack) {
-        emit("popq", SizedRegister(Register::RBP, 8));
+        emit(X86Opcode::POP, 8, SizedRegister(Register::RBP, 8));
         m_stackAlignment--;
     }
-    emit("ret");
+    emit(X86Opcode::RET, 0);
+
+    {
+        CompileReport::Scope scope(m_report, "simplify asm");
+        simplifyAsm();
+    }
+
+    if (m_code) {
+        CompileReport::Scope scope(m_report, "encode");
+        *m_code = encodeFunction(function.symbol(), m_instructions);
+        return;
+    }
 
-    simplifyAsm();
+    CompileReport::Scope printScope(m_report, "print asm");
+    m_asm << ".section .text\n";
+    m_asm << ".global " << function.name() << "\n";
+    m_asm << function.name() << ":\n";
     printAsm();
 
-    m_out << "\n";
-    m_out << ".section .rodata\n";
-    int i = 0;
-    for (const auto& literal : function.literals()) {
-        m_out << literalLabel(StringLiteral(i)) << ":\n";
-        m_out << "    .asciz\t\"" << literal << "\"\n";
-        i++;
+    m_asm << "\n";
+    m_asm.flush(*m_out);
+}
+
+void X86GenVisitor::printLiterals(std::ostream& out, const StringInterner& literals) {
+    if (literals.size() == 0) {
+        return;
     }
+
+    // Null terminated strings of 1 byte characters that the linker can merge with the ones of other objects. The
+    // linker splits this section at each NUL, so a literal with a NUL before its end would lose the bytes after
+    // it: those go to .rodata, which is never merged
+    std::vector<Symbol> withNul;
+    AsmBuffer buffer;
+    buffer << ".section .rodata.str1.1,\"aMS\",@progbits,1\n";
+    for (Symbol i = 0; i < literals.size(); i++) {
+        if (decodeLiteral(literals.text(i)).find('\0') != std::string::npos) {
+            withNul.push_back(i);
+            continue;
+        }
+        buffer << ".L.str." << i << ":\n";
+        buffer << "    .asciz\t\"" << literals.text(i) << "\"\n";
+    }
+    if (!withNul.empty()) {
+        buffer << ".section .rodata\n";
+        for (Symbol i : withNul) {
+            buffer << ".L.str." << i << ":\n";
+            buffer << "    .asciz\t\"" << literals.text(i) << "\"\n";
+        }
+    }
+    buffer.flush(out);
 }
 
 void X86GenVisitor::visit(ir::BasicBlock& block) {
     m_currentBlock = &block;
     m_optimizedCond = std::nullopt;
-    emit(std::string_view(block.label()), std::string_view(":"));
+    emit(X86Opcode::LABEL, 0, Label(&block));
     for (auto& instr : block.instructions()) {
         visitBase(*instr);
     }
@@ -224,29 +280,27 @@ void X86GenVisitor::visit(ir::BasicBlock& block) {
     }
 }
 
-void X86GenVisitor::emitSimpleArithmetic(std::string_view instruction, const BinaryOp& binaryOp) {
+void X86GenVisitor::emitSimpleArithmetic(X86Opcode opcode, const BinaryOp& binaryOp) {
     auto size = binaryOp.destination().type()->size();
     SizedRegister reg = {Register::RAX, size};
-    auto suffix = getSuffix(size);
 
     auto rightReg = rvalueRegister(binaryOp.right());
     auto destReg = variableRegister(binaryOp.destination());
 
     if (destReg && (!rightReg || rightReg.value() != destReg.value())) {
         reg.reg = destReg.value();
-        emit("mov", suffix, binaryOp.left(), reg);
-        emit(instruction, suffix, binaryOp.right(), reg);
+        emit(X86Opcode::MOV, size, binaryOp.left(), reg);
+        emit(opcode, size, binaryOp.right(), reg);
     } else {
-        emit("mov", suffix, binaryOp.left(), reg);
-        emit(instruction, suffix, binaryOp.right(), reg);
-        emit("mov", suffix, reg, binaryOp.destination());
+        emit(X86Opcode::MOV, size, binaryOp.left(), reg);
+        emit(opcode, size, binaryOp.right(), reg);
+        emit(X86Opcode::MOV, size, reg, binaryOp.destination());
     }
 }
 
-void X86GenVisitor::emitSimpleArithmeticCommutative(std::string_view instruction, const ir::BinaryOp& binaryOp) {
+void X86GenVisitor::emitSimpleArithmeticCommutative(X86Opcode opcode, const ir::BinaryOp& binaryOp) {
     auto size = binaryOp.destination().type()->size();
     SizedRegister reg = {Register::RAX, size};
-    auto suffix = getSuffix(size);
 
     auto leftReg = rvalueRegister(binaryOp.left());
     auto rightReg = rvalueRegister(binaryOp.right());
@@ -254,23 +308,22 @@ void X86GenVisitor::emitSimpleArithmeticCommutative(std::string_view instruction
 
     if (destReg && (!rightReg || rightReg.value() != destReg.value())) {
         reg.reg = destReg.value();
-        emit("mov", suffix, binaryOp.left(), reg);
-        emit(instruction, suffix, binaryOp.right(), reg);
+        emit(X86Opcode::MOV, size, binaryOp.left(), reg);
+        emit(opcode, size, binaryOp.right(), reg);
     } else if (destReg && (!leftReg || leftReg.value() != destReg.value())) {
         reg.reg = destReg.value();
-        emit("mov", suffix, binaryOp.right(), reg);
-        emit(instruction, suffix, binaryOp.left(), reg);
+        emit(X86Opcode::MOV, size, binaryOp.right(), reg);
+        emit(opcode, size, binaryOp.left(), reg);
     } else {
-        emit("mov", suffix, binaryOp.left(), reg);
-        emit(instruction, suffix, binaryOp.right(), reg);
-        emit("mov", suffix, reg, binaryOp.destination());
+        emit(X86Opcode::MOV, size, binaryOp.left(), reg);
+        emit(opcode, size, binaryOp.right(), reg);
+        emit(X86Opcode::MOV, size, reg, binaryOp.destination());
     }
 }
 
-void X86GenVisitor::emitCmp(std::string_view instructionSuffix, const ir::BinaryOp& binaryOp) {
-    auto operandSize = std::visit([](auto val) { return val.type()->size(); }, binaryOp.left());
-    SizedRegister rax = {Register::RAX, operandSize};
-    auto suffix = getSuffix(operandSize);
+void X86GenVisitor::emitCmp(ConditionCode condition, const ir::BinaryOp& binaryOp) {
+    auto size = std::visit([](auto val) { return val.type()->size(); }, binaryOp.left());
+    SizedRegister rax = {Register::RAX, size};
 
     SizedRegister sourceReg = rax;
     if (auto regOpt = rvalueRegister(binaryOp.left()); regOpt) {
@@ -278,18 +331,18 @@ void X86GenVisitor::emitCmp(std::string_view instructionSuffix, const ir::Binary
     } else if (auto regOpt = rvalueRegister(binaryOp.right()); regOpt) {
         sourceReg.reg = regOpt.value();
     } else {
-        emit("mov", suffix, binaryOp.left(), sourceReg);
+        emit(X86Opcode::MOV, size, binaryOp.left(), sourceReg);
     }
 
-    emit("cmp", suffix, binaryOp.right(), sourceReg);
+    emit(X86Opcode::CMP, size, binaryOp.right(), sourceReg);
 
-    if (m_currentBlock->instructions().back().get() == &binaryOp &&
+    if (m_currentBlock->instructions().back() == &binaryOp &&
         !m_livenessAnalysis[m_currentBlock].second.contains(binaryOp.destination())) {
-        ConditionalJump* jump = dynamic_cast<ConditionalJump*>(m_currentBlock->terminator().get());
+        ConditionalJump* jump = dynamic_cast<ConditionalJump*>(m_currentBlock->terminator());
         if (jump) {
             if (std::holds_alternative<Local>(jump->condition()) &&
                 std::get<Local>(jump->condition()) == binaryOp.destination()) {
-                m_optimizedCond = instructionSuffix;
+                m_optimizedCond = condition;
                 return;
             }
         }
@@ -298,11 +351,11 @@ void X86GenVisitor::emitCmp(std::string_view instructionSuffix, const ir::Binary
     auto optionalReg = variableRegister(binaryOp.destination());
     if (optionalReg) {
         SizedRegister reg{optionalReg.value(), 1};
-        emit("set", instructionSuffix, reg);
+        emitConditional(X86Opcode::SET, condition, reg);
     } else {
         SizedRegister al{Register::RAX, 1};
-        emit("set", instructionSuffix, al);
-        emit("mov", getSuffix(1), al, binaryOp.destination());
+        emitConditional(X86Opcode::SET, condition, al);
+        emit(X86Opcode::MOV, 1, al, binaryOp.destination());
     }
 }
 
@@ -312,49 +365,43 @@ void X86GenVisitor::emitDiv(bool modulo, const ir::BinaryOp& binaryOp) {
     SizedRegister rax = {Register::RAX, size};
     SizedRegister rdx = {Register::RDX, size};
     SizedRegister rcx = {Register::RCX, size};
-    auto suffix = getSuffix(size);
-    emit("mov", suffix, binaryOp.left(), rax);
+    emit(X86Opcode::MOV, size, binaryOp.left(), rax);
 
-    switch (size) {
-        case 8: emit("cqto"); break;
-        case 4: emit("cltd"); break;
-        case 2: emit("cwtd"); break;
-        case 1: emit("cbtw"); break;
-        default: throw std::runtime_error("Unsupported size");
-    }
+    emit(X86Opcode::SIGN_EXTEND_ACCUMULATOR, size);
 
     if (std::holds_alternative<Local>(binaryOp.right())) {
         Local rightLocal = std::get<Local>(binaryOp.right());
-        emit("idiv", suffix, rightLocal);
+        emit(X86Opcode::IDIV, size, rightLocal);
     } else {
         Immediate rightImmediate = std::get<Immediate>(binaryOp.right());
-        emit("mov", suffix, rightImmediate, rcx);
-        emit("idiv", suffix, rcx);
+        emit(X86Opcode::MOV, size, rightImmediate, rcx);
+        emit(X86Opcode::IDIV, size, rcx);
     }
 
     if (modulo) {
-        emit("mov", suffix, rdx, binaryOp.destination());
+        emit(X86Opcode::MOV, size, rdx, binaryOp.destination());
     } else {
-        emit("mov", suffix, rax, binaryOp.destination());
+        emit(X86Opcode::MOV, size, rax, binaryOp.destination());
     }
 }
 
 void X86GenVisitor::visit(ir::BinaryOp& binaryOp) {
     switch (binaryOp.operation()) {
-        case BinaryOpKind::ADD: emitSimpleArithmeticCommutative("add", binaryOp); break;
-        case BinaryOpKind::SUB: emitSimpleArithmetic("sub", binaryOp); break;
-        case BinaryOpKind::MUL: emitSimpleArithmeticCommutative("imul", binaryOp); break;
+        case BinaryOpKind::ADD: emitSimpleArithmeticCommutative(X86Opcode::ADD, binaryOp); break;
+        case BinaryOpKind::SUB: emitSimpleArithmetic(X86Opcode::SUB, binaryOp); break;
+        case BinaryOpKind::MUL: emitSimpleArithmeticCommutative(X86Opcode::IMUL, binaryOp); break;
         case BinaryOpKind::DIV: emitDiv(false, binaryOp); break;
         case BinaryOpKind::MOD: emitDiv(true, binaryOp); break;
-        case BinaryOpKind::EQ: emitCmp("e", binaryOp); break;
-        case BinaryOpKind::NEQ: emitCmp("ne", binaryOp); break;
-        case BinaryOpKind::CMP_L: emitCmp("l", binaryOp); break;
-        case BinaryOpKind::CMP_G: emitCmp("g", binaryOp); break;
-        case BinaryOpKind::CMP_LE: emitCmp("le", binaryOp); break;
-        case BinaryOpKind::CMP_GE: emitCmp("ge", binaryOp); break;
-        case BinaryOpKind::BIT_AND: emitSimpleArithmeticCommutative("and", binaryOp); break;
-        case BinaryOpKind::BIT_XOR: emitSimpleArithmeticCommutative("xor", binaryOp); break;
-        case BinaryOpKind::BIT_OR: emitSimpleArithmeticCommutative("or", binaryOp); break;
+        case BinaryOpKind::EQ: emitCmp(ConditionCode::E, binaryOp); break;
+        case BinaryOpKind::NEQ: emitCmp(ConditionCode::NE, binaryOp); break;
+        case BinaryOpKind::CMP_L: emitCmp(ConditionCode::L, binaryOp); break;
+        case BinaryOpKind::CMP_G: emitCmp(ConditionCode::G, binaryOp); break;
+        case BinaryOpKind::CMP_LE: emitCmp(ConditionCode::LE, binaryOp); break;
+        case BinaryOpKind::CMP_GE: emitCmp(ConditionCode::GE, binaryOp); break;
+        case BinaryOpKind::BIT_AND: emitSimpleArithmeticCommutative(X86Opcode::AND, binaryOp); break;
+        case BinaryOpKind::BIT_XOR: emitSimpleArithmeticCommutative(X86Opcode::XOR, binaryOp); break;
+        case BinaryOpKind::BIT_OR: emitSimpleArithmeticCommutative(X86Opcode::OR, binaryOp); break;
+        case BinaryOpKind::SHL: emitSimpleArithmetic(X86Opcode::SHL, binaryOp); break;
     }
 }
 
@@ -363,19 +410,18 @@ void X86GenVisitor::visit(ir::UnaryOp& unaryOp) {
     SizedRegister rax = {Register::RAX, size};
     SizedRegister al = {Register::RAX, types::BOOL->size()};
 
-    auto suffix = getSuffix(size);
 
     switch (unaryOp.operation()) {
         case UnaryOpKind::MINUS: {
             auto optionalReg = variableRegister(unaryOp.destination());
             if (optionalReg) {
                 SizedRegister reg = SizedRegister{optionalReg.value(), unaryOp.destination().type()->size()};
-                emit("mov", suffix, unaryOp.operand(), reg);
-                emit("neg", suffix, reg);
+                emit(X86Opcode::MOV, size, unaryOp.operand(), reg);
+                emit(X86Opcode::NEG, size, reg);
             } else {
-                emit("mov", suffix, unaryOp.operand(), rax);
-                emit("neg", suffix, rax);
-                emit("mov", suffix, rax, unaryOp.destination());
+                emit(X86Opcode::MOV, size, unaryOp.operand(), rax);
+                emit(X86Opcode::NEG, size, rax);
+                emit(X86Opcode::MOV, size, rax, unaryOp.destination());
             }
         } break;
         case UnaryOpKind::NOT: {
@@ -384,18 +430,18 @@ void X86GenVisitor::visit(ir::UnaryOp& unaryOp) {
             if (optionalReg) {
                 sourceReg.reg = optionalReg.value();
             } else {
-                emit("mov", suffix, unaryOp.operand(), rax);
+                emit(X86Opcode::MOV, size, unaryOp.operand(), rax);
             }
 
-            emit("test", sourceReg, sourceReg);
+            emit(X86Opcode::TEST, 0, sourceReg, sourceReg);
 
-            if (m_currentBlock->instructions().back().get() == &unaryOp &&
+            if (m_currentBlock->instructions().back() == &unaryOp &&
                 !m_livenessAnalysis[m_currentBlock].second.contains(unaryOp.destination())) {
-                ConditionalJump* jump = dynamic_cast<ConditionalJump*>(m_currentBlock->terminator().get());
+                ConditionalJump* jump = dynamic_cast<ConditionalJump*>(m_currentBlock->terminator());
                 if (jump) {
                     if (std::holds_alternative<Local>(jump->condition()) &&
                         std::get<Local>(jump->condition()) == unaryOp.destination()) {
-                        m_optimizedCond = "z";
+                        m_optimizedCond = ConditionCode::Z;
                         return;
                     }
                 }
@@ -404,17 +450,17 @@ void X86GenVisitor::visit(ir::UnaryOp& unaryOp) {
             optionalReg = variableRegister(unaryOp.destination());
             if (optionalReg) {
                 SizedRegister reg{optionalReg.value(), unaryOp.destination().type()->size()};
-                emit("setz", reg);
+                emitConditional(X86Opcode::SET, ConditionCode::Z, reg);
             } else {
-                emit("setz", al);
-                emit("movb", al, unaryOp.destination());
+                emitConditional(X86Opcode::SET, ConditionCode::Z, al);
+                emit(X86Opcode::MOV, 1, al, unaryOp.destination());
             }
         } break;
     }
 }
 
 void X86GenVisitor::visit(ir::Assignment& assignment) {
-    auto suffix = getSuffix(assignment.destination().type()->size());
+    auto size = assignment.destination().type()->size();
 
     if (std::holds_alternative<Local>(assignment.source())) {
         Local source = std::get<Local>(assignment.source());
@@ -426,46 +472,47 @@ void X86GenVisitor::visit(ir::Assignment& assignment) {
         }
 
         SizedRegister dest{destReg, source.type()->size()};
-        emit("mov", suffix, source, dest);
+        emit(X86Opcode::MOV, size, source, dest);
         if (!destOpt) {
-            emit("mov", suffix, dest, assignment.destination());
+            emit(X86Opcode::MOV, size, dest, assignment.destination());
         }
     } else {
         Immediate source = std::get<Immediate>(assignment.source());
-        emit("mov", suffix, source, assignment.destination());
+        emit(X86Opcode::MOV, size, source, assignment.destination());
     }
 }
 
-void X86GenVisitor::visit(ir::BasicJump& jump) { emit("jmp", Label(jump.target()->label())); }
+void X86GenVisitor::visit(ir::BasicJump& jump) { emit(X86Opcode::JMP, 0, Label(jump.target())); }
 void X86GenVisitor::visit(ir::ConditionalJump& jump) {
     auto size = std::visit([](auto val) { return val.type()->size(); }, jump.condition());
-    auto suffix = getSuffix(size);
     SizedRegister reg = {Register::RAX, size};
 
     if (m_optimizedCond.has_value()) {
-        emit("j", m_optimizedCond.value(), Label(jump.trueTarget()->label()));
+        emitConditional(X86Opcode::J, m_optimizedCond.value(), Label(jump.trueTarget()));
     } else {
         auto optionalReg = rvalueRegister(jump.condition());
         if (optionalReg) {
             reg.reg = optionalReg.value();
         } else {
-            emit("mov", suffix, jump.condition(), reg);
+            emit(X86Opcode::MOV, size, jump.condition(), reg);
         }
-        emit("test", reg, reg);
-        emit("jne", Label(jump.trueTarget()->label()));
+        emit(X86Opcode::TEST, 0, reg, reg);
+        emitConditional(X86Opcode::J, ConditionCode::NE, Label(jump.trueTarget()));
     }
-    emit("jmp", Label(jump.falseTarget()->label()));
+    emit(X86Opcode::JMP, 0, Label(jump.falseTarget()));
 }
 
 void X86GenVisitor::visit(ir::Call& call) {
     const auto& [before, after] = m_localsUsedThroughCalls.at(&call);
+    LiveSet liveThroughCall = before;
+    liveThroughCall.intersect(after);
+
     std::vector<Register> savedRegister;
-    for (const auto& local : before) {
-        if (!after.contains(local))
-            continue;
+    for (LocalId localId : liveThroughCall) {
+        Local local{localId, m_currentFunction->locals()[localId].type()};
         auto optReg = variableRegister(local);
         if (optReg && !preserved(optReg.value())) {
-            emit("pushq", SizedRegister(optReg.value(), 8));
+            emit(X86Opcode::PUSH, 8, SizedRegister(optReg.value(), 8));
             savedRegister.push_back(optReg.value());
             m_stackAlignment++;
         }
@@ -474,9 +521,9 @@ void X86GenVisitor::visit(ir::Call& call) {
     for (size_t i = 0; i < call.args().size() && i < ARGS_IN_REGISTER; i++) {
         RValue arg = call.args()[i];
         auto type = std::visit([](auto val) { return val.type(); }, arg);
-        auto suffix = getSuffix(type->size());
+        auto size = type->size();
         SizedRegister reg = {CALL_REGISTER[i], type->size()};
-        emit("mov", suffix, arg, reg);
+        emit(X86Opcode::MOV, size, arg, reg);
     }
 
     if (call.args().size() > ARGS_IN_REGISTER) {
@@ -486,49 +533,51 @@ void X86GenVisitor::visit(ir::Call& call) {
     bool alignmentCorrection = m_stackAlignment % 2 == 1;
 
     if (alignmentCorrection) {
-        emit("pushq", SizedRegister{Register::RCX, 8});
+        emit(X86Opcode::PUSH, 8, SizedRegister{Register::RCX, 8});
     }
 
     for (int i = call.args().size() - 1; i >= (int)ARGS_IN_REGISTER; i--) {
-        std::cerr << i << " " << call.args().size() << std::endl;
+        if (m_log) {
+            *m_log << "stack argument " << i << " of " << call.args().size() << std::endl;
+        }
         RValue arg = call.args()[i];
         auto type = std::visit([](auto val) { return val.type(); }, arg);
-        auto suffix = getSuffix(type->size());
+        auto size = type->size();
 
         SizedRegister rax{Register::RAX, 8};
         SizedRegister ax{Register::RAX, type->size()};
         auto optionalReg = rvalueRegister(arg);
         if (optionalReg) {
-            emit("pushq", SizedRegister(optionalReg.value(), 8));
+            emit(X86Opcode::PUSH, 8, SizedRegister(optionalReg.value(), 8));
         } else {
-            emit("mov", suffix, arg, ax);
-            emit("pushq", rax);
+            emit(X86Opcode::MOV, size, arg, ax);
+            emit(X86Opcode::PUSH, 8, rax);
         }
     }
 
     if (call.variadic()) {
-        emit("movq", Immediate(0, types::LONG), SizedRegister(Register::RAX, 8));
+        emit(X86Opcode::MOV, 8, Immediate(0, types::LONG), SizedRegister(Register::RAX, 8));
     }
 
-    emit("call", FunctionLabel(call.name()));
+    emit(X86Opcode::CALL, 0, FunctionLabel(call.symbol()));
 
     if (alignmentCorrection) {
-        emit("popq", SizedRegister{Register::RCX, 8});
+        emit(X86Opcode::POP, 8, SizedRegister{Register::RCX, 8});
     }
 
     for (size_t i = ARGS_IN_REGISTER; i < call.args().size(); i++) {
-        emit("popq", SizedRegister(Register::RCX, 8));
+        emit(X86Opcode::POP, 8, SizedRegister(Register::RCX, 8));
         m_stackAlignment--;
     }
 
     if (call.destination().type()->size() > 0) {
         SizedRegister rax = {Register::RAX, call.destination().type()->size()};
-        auto suffix = getSuffix(rax.size);
-        emit("mov", suffix, rax, call.destination());
+        auto size = rax.size;
+        emit(X86Opcode::MOV, size, rax, call.destination());
     }
 
     for (const auto& saved : savedRegister | std::views::reverse) {
-        emit("popq", SizedRegister(saved, 8));
+        emit(X86Opcode::POP, 8, SizedRegister(saved, 8));
         m_stackAlignment--;
     }
 }
@@ -537,28 +586,37 @@ void X86GenVisitor::visit(ir::Cast& cast) {
     auto sourceType = std::visit([](auto val) { return val.type(); }, cast.source());
     auto destinationType = cast.destination().type();
     SizedRegister reg = {Register::RAX, destinationType->size()};
-    if (sourceType->size() < destinationType->size()) {
-        std::stringstream suffix;
-        suffix << getSuffix(sourceType->size()) << getSuffix(destinationType->size());
+    bool immediateSource = std::holds_alternative<Immediate>(cast.source());
+    if (sourceType->size() < destinationType->size() && !immediateSource) {
         auto optionalReg = variableRegister(cast.destination());
         if (optionalReg) {
             reg.reg = optionalReg.value();
-            emit("movs", std::string_view(suffix.str()), cast.source(), reg);
+            emitMovs(sourceType->size(), destinationType->size(), cast.source(), reg);
         } else {
-            emit("movs", std::string_view(suffix.str()), cast.source(), reg);
-            emit("mov", getSuffix(destinationType->size()), reg, cast.destination());
+            emitMovs(sourceType->size(), destinationType->size(), cast.source(), reg);
+            emit(X86Opcode::MOV, destinationType->size(), reg, cast.destination());
         }
     } else {
-        auto suffix = getSuffix(destinationType->size());
+        auto size = destinationType->size();
         auto optionalReg = variableRegister(cast.destination());
         RValue source = cast.source();
+        if (immediateSource) {
+            // movs can't take an immediate so sign extend it here. Only happens when folding is disabled
+            Immediate immediate = std::get<Immediate>(source);
+            switch (sourceType->size()) {
+                case 1: source = Immediate(immediate.value8(), destinationType); break;
+                case 2: source = Immediate(immediate.value16(), destinationType); break;
+                case 4: source = Immediate(immediate.value32(), destinationType); break;
+                default: source = Immediate(immediate.value64(), destinationType); break;
+            }
+        }
         std::visit([&](auto& source) { source.setType(destinationType); }, source);
         if (optionalReg) {
             reg.reg = optionalReg.value();
-            emit("mov", suffix, source, reg);
+            emit(X86Opcode::MOV, size, source, reg);
         } else {
-            emit("mov", suffix, source, reg);
-            emit("mov", suffix, reg, cast.destination());
+            emit(X86Opcode::MOV, size, source, reg);
+            emit(X86Opcode::MOV, size, reg, cast.destination());
         }
     }
 }
@@ -567,23 +625,23 @@ void X86GenVisitor::visit(ir::PointerRead& pointerRead) {
     auto type = pointerRead.destination().type();
     SizedRegister destReg{Register::RAX, type->size()};
     SizedRegister sourceReg{Register::RDX, 8};
-    auto suffix = getSuffix(destReg.size);
+    auto size = destReg.size;
 
     auto optionalReg = rvalueRegister(pointerRead.address());
     if (optionalReg) {
         sourceReg.reg = optionalReg.value();
     } else {
-        emit("movq", pointerRead.address(), sourceReg);
+        emit(X86Opcode::MOV, 8, pointerRead.address(), sourceReg);
     }
 
     optionalReg = variableRegister(pointerRead.destination());
     if (optionalReg) {
         destReg.reg = optionalReg.value();
-        emit("mov", suffix, Deref(sourceReg), destReg);
+        emit(X86Opcode::MOV, size, Deref(sourceReg), destReg);
     } else {
 
-        emit("mov", suffix, Deref(sourceReg), destReg);
-        emit("mov", suffix, destReg, pointerRead.destination());
+        emit(X86Opcode::MOV, size, Deref(sourceReg), destReg);
+        emit(X86Opcode::MOV, size, destReg, pointerRead.destination());
     }
 }
 
@@ -591,24 +649,24 @@ void X86GenVisitor::visit(ir::PointerWrite& pointerWrite) {
     auto type = std::visit([](auto val) { return val.type(); }, pointerWrite.source());
     SizedRegister sourceReg{Register::RAX, type->size()};
     SizedRegister addressReg{Register::RDX, 8};
-    auto suffix = getSuffix(sourceReg.size);
+    auto size = sourceReg.size;
 
     auto optionalReg = rvalueRegister(pointerWrite.address());
     if (optionalReg) {
         addressReg.reg = optionalReg.value();
     } else {
-        emit("movq", pointerWrite.address(), addressReg);
+        emit(X86Opcode::MOV, 8, pointerWrite.address(), addressReg);
     }
 
     optionalReg = rvalueRegister(pointerWrite.source());
     if (optionalReg) {
         sourceReg.reg = optionalReg.value();
-        emit("mov", suffix, sourceReg, Deref(addressReg));
+        emit(X86Opcode::MOV, size, sourceReg, Deref(addressReg));
     } else if (std::holds_alternative<Immediate>(pointerWrite.source())) {
-        emit("mov", suffix, std::get<Immediate>(pointerWrite.source()), Deref(addressReg));
+        emit(X86Opcode::MOV, size, std::get<Immediate>(pointerWrite.source()), Deref(addressReg));
     } else {
-        emit("mov", suffix, pointerWrite.source(), sourceReg);
-        emit("mov", suffix, sourceReg, Deref(addressReg));
+        emit(X86Opcode::MOV, size, pointerWrite.source(), sourceReg);
+        emit(X86Opcode::MOV, size, sourceReg, Deref(addressReg));
     }
 }
 
@@ -619,81 +677,68 @@ void X86GenVisitor::visit(ir::AddressOf& addressOf) {
         auto optionalReg = variableRegister(addressOf.destination());
         if (optionalReg) {
             destReg.reg = optionalReg.value();
-            emit("leaq", source, destReg);
+            emit(X86Opcode::LEA, 8, source, destReg);
         } else {
-            emit("leaq", source, destReg);
-            emit("movq", destReg, addressOf.destination());
+            emit(X86Opcode::LEA, 8, source, destReg);
+            emit(X86Opcode::MOV, 8, destReg, addressOf.destination());
         }
     } else {
         StringLiteral literal = std::get<StringLiteral>(addressOf.source());
         auto optionalReg = variableRegister(addressOf.destination());
         if (optionalReg) {
             destReg.reg = optionalReg.value();
-            emit("leaq", DataLabel(literalLabel(literal)), destReg);
+            emit(X86Opcode::LEA, 8, DataLabel(literal.id()), destReg);
         } else {
-            emit("leaq", DataLabel(literalLabel(literal)), destReg);
-            emit("movq", destReg, addressOf.destination());
+            emit(X86Opcode::LEA, 8, DataLabel(literal.id()), destReg);
+            emit(X86Opcode::MOV, 8, destReg, addressOf.destination());
         }
     }
 }
 
 void X86GenVisitor::simplifyAsm() {
+    auto isJump = [](const MachineInstruction& instr) {
+        return instr.opcode == X86Opcode::JMP || instr.opcode == X86Opcode::J;
+    };
+
     bool changed = true;
     while (changed) {
         changed = false;
-        std::unordered_set<std::string> usedLabels;
+        // Indexed by BasicBlock::index()
+        std::vector<bool> usedLabels(m_currentFunction->blocks().size() + 2, false);
+
+        size_t kept = 0;
         for (size_t i = 0; i < m_instructions.size(); i++) {
-            auto& instr = m_instructions[i];
-            if (instr.empty())
-                continue;
+            const auto& instr = m_instructions[i];
 
-            if ((instr[0] == "movq" || instr[0] == "movl" || instr[0] == "movw" || instr[0] == "movb") &&
-                instr.at(1) == instr.at(2)) {
-                instr.clear();
+            if (instr.opcode == X86Opcode::MOV && instr.operands[0] == instr.operands[1]) {
                 changed = true;
                 continue;
             }
 
-            if (i != m_instructions.size() - 1) {
-                if (instr[0] == "jmp" && m_instructions[i + 1][0].starts_with(instr[1])) {
-                    instr.clear();
-                    changed = true;
-                    continue;
-                }
+            // Jump to the label just after
+            if (instr.opcode == X86Opcode::JMP && i != m_instructions.size() - 1 &&
+                m_instructions[i + 1].opcode == X86Opcode::LABEL &&
+                m_instructions[i + 1].operands[0] == instr.operands[0]) {
+                changed = true;
+                continue;
             }
 
-            if (instr[0].starts_with("j") && instr.size() > 1) {
-                usedLabels.insert(instr[1]);
+            if (isJump(instr)) {
+                usedLabels[std::get<Label>(instr.operands[0]).block->index()] = true;
             }
-        }
-
-        for (auto& instr : m_instructions) {
-            if (instr.empty())
-                continue;
 
-            if (instr[0].ends_with(":") && !usedLabels.contains(instr[0].substr(0, instr[0].size() - 1))) {
-                instr.clear();
-            }
+            m_instructions[kept++] = instr;
         }
+        m_instructions.resize(kept);
 
-        auto it = std::remove_if(m_instructions.begin(), m_instructions.end(), [](auto vec) { return vec.empty(); });
-        if (it != m_instructions.end())
-            m_instructions.erase(it);
+        std::erase_if(m_instructions, [&](const MachineInstruction& instr) {
+            return instr.opcode == X86Opcode::LABEL && !usedLabels[std::get<Label>(instr.operands[0]).block->index()];
+        });
     }
 }
 
 void X86GenVisitor::printAsm() {
     for (const auto& instr : m_instructions) {
-        if (instr.empty())
-            continue;
-        if (!instr[0].ends_with(":"))
-            m_out << "\t";
-        m_out << instr[0] << "\t";
-        for (size_t i = 1; i < instr.size(); i++) {
-            if (i != 1)
-                m_out << ", ";
-            m_out << instr[i];
-        }
-        m_out << "\n";
+        printInstruction(m_asm, instr);
     }
 }
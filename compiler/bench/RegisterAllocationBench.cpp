@@ -0,0 +1,83 @@
+// Benchmark of computeRegisterAllocation on synthetic interference graphs.
+// Usage : RegisterAllocationBench [node count...]
+//
+// Locals get a random live range as if they were temporaries of a long function, so the graph has
+// the shape of a real interference graph. The time per node + edge should stay roughly constant.
+
+#include "../InterferenceGraph.h"
+#include "../RegisterAllocation.h"
+#include "../ir/Ir.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <vector>
+
+constexpr uint32_t REGISTER_COUNT = 14;
+constexpr uint32_t MAX_LIVE_RANGE = 12;
+constexpr int REPETITIONS = 3;
+
+static InterferenceGraph generateGraph(size_t localCount, std::mt19937& random) {
+    InterferenceGraph graph{localCount};
+    std::uniform_int_distribution<uint32_t> liveRange(1, MAX_LIVE_RANGE);
+
+    for (LocalId local = 0; local < localCount; local++) {
+        // A few locals live much longer, like loop counters or accumulators
+        uint32_t range = local % 97 == 0 ? 20 * MAX_LIVE_RANGE : liveRange(random);
+        for (LocalId other = local + 1; other < localCount && other < local + range; other++) {
+            graph.addInterference(local, other);
+        }
+    }
+
+    return graph;
+}
+
+int main(int argc, char** argv) {
+    std::vector<size_t> sizes = {1000, 2000, 5000, 10000, 20000, 50000};
+    if (argc > 1) {
+        sizes.clear();
+        for (int i = 1; i < argc; i++) {
+            sizes.push_back(std::strtoul(argv[i], nullptr, 10));
+        }
+    }
+
+    std::cout << std::setw(8) << "nodes" << std::setw(10) << "edges" << std::setw(9) << "spilled" << std::setw(12)
+              << "time (ms)" << std::setw(18) << "ns/(node+edge)" << std::endl;
+
+    std::mt19937 random{42};
+    for (size_t size : sizes) {
+        ir::Function function{"bench", 0, types::INT};
+        for (size_t i = 1; i < size; i++) {
+            function.newLocal(types::INT);
+        }
+
+        InterferenceGraph graph = generateGraph(size, random);
+        size_t edges = 0;
+        for (LocalId local = 0; local < size; local++) {
+            edges += graph.neighbors(local).size();
+        }
+        edges /= 2;
+
+        PointedLocals pointedLocals;
+        double bestTime = 0;
+        size_t spilled = 0;
+        for (int i = 0; i < REPETITIONS; i++) {
+            auto start = std::chrono::steady_clock::now();
+            auto result = computeRegisterAllocation(function, pointedLocals, graph, REGISTER_COUNT);
+            std::chrono::duration<double, std::milli> time = std::chrono::steady_clock::now() - start;
+
+            if (i == 0 || time.count() < bestTime) {
+                bestTime = time.count();
+            }
+            spilled = result.spilled().size();
+        }
+
+        std::cout << std::setw(8) << size << std::setw(10) << edges << std::setw(9) << spilled << std::setw(12)
+                  << std::fixed << std::setprecision(3) << bestTime << std::setw(18) << std::setprecision(1)
+                  << bestTime * 1e6 / (size + edges) << std::endl;
+    }
+
+    return 0;
+}
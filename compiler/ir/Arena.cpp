@@ -0,0 +1,47 @@
+#include "Arena.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <ranges>
+
+using namespace ir;
+
+void* Arena::allocate(size_t size, size_t alignment) {
+    auto aligned = [alignment](std::byte* ptr) {
+        auto address = reinterpret_cast<uintptr_t>(ptr);
+        return reinterpret_cast<std::byte*>((address + alignment - 1) & ~(uintptr_t)(alignment - 1));
+    };
+
+    std::byte* start = m_cursor ? aligned(m_cursor) : nullptr;
+    if (!start || start + size > m_end) {
+        // Big objects get their own chunk
+        size_t chunkSize = std::max(CHUNK_SIZE, size + alignment);
+        m_chunks.push_back(std::make_unique<std::byte[]>(chunkSize));
+        m_bytesReserved += chunkSize;
+
+        m_cursor = m_chunks.back().get();
+        m_end = m_cursor + chunkSize;
+        start = aligned(m_cursor);
+    }
+
+    m_cursor = start + size;
+    m_bytesUsed += size;
+    return start;
+}
+
+void Arena::release() {
+    // Destroy in reverse order of construction like the compiler would do
+    for (auto& destructor : m_destructors | std::views::reverse) {
+        destructor.destroy(destructor.object);
+    }
+
+    // Clearing keeps the capacity, a released function would still hold a slot per instruction
+    m_destructors.clear();
+    m_destructors.shrink_to_fit();
+    m_chunks.clear();
+    m_chunks.shrink_to_fit();
+    m_cursor = nullptr;
+    m_end = nullptr;
+    m_bytesUsed = 0;
+    m_bytesReserved = 0;
+}
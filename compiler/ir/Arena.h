@@ -0,0 +1,69 @@
+#pragma once
+
+#include <cstddef>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace ir {
+
+    // Bump allocator owning every Instruction and Terminator of a Function.
+    // Objects are never freed one by one : everything is destroyed at once when the arena is released.
+    class Arena {
+      public:
+        Arena() = default;
+        Arena(const Arena&) = delete;
+        Arena& operator=(const Arena&) = delete;
+
+        ~Arena() { release(); }
+
+        // Construct an object of type T inside the arena and return a pointer to it.
+        // The pointer stays valid until the arena is released.
+        template <class T, class... Args>
+        T* create(Args&&... args) {
+            void* memory = allocate(sizeof(T), alignof(T));
+            T* object = new (memory) T(std::forward<Args>(args)...);
+
+            // Instructions own vectors or strings (Call arguments for example) so we have to remember how to
+            // destroy them
+            if constexpr (!std::is_trivially_destructible_v<T>) {
+                m_destructors.push_back({object, [](void* ptr) { static_cast<T*>(ptr)->~T(); }});
+            }
+
+            return object;
+        }
+
+        // Destroy every object of the arena and give the memory back to the system
+        void release();
+
+        // Number of bytes handed out to objects
+        size_t bytesUsed() const { return m_bytesUsed; }
+
+        // Number of bytes allocated from the system
+        size_t bytesReserved() const { return m_bytesReserved; }
+
+        size_t chunkCount() const { return m_chunks.size(); }
+
+      private:
+        static constexpr size_t CHUNK_SIZE = 4096;
+
+        struct Destructor {
+            void* object;
+            void (*destroy)(void*);
+        };
+
+        std::vector<std::unique_ptr<std::byte[]>> m_chunks;
+        std::vector<Destructor> m_destructors;
+
+        // Free space of the current chunk
+        std::byte* m_cursor = nullptr;
+        std::byte* m_end = nullptr;
+
+        size_t m_bytesUsed = 0;
+        size_t m_bytesReserved = 0;
+
+        void* allocate(size_t size, size_t alignment);
+    };
+}
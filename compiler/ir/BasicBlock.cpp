@@ -1,5 +1,6 @@
 #include "BasicBlock.h"
 #include "Visitor.h"
+#include <sstream>
 
 using namespace ir;
 
@@ -7,3 +8,8 @@ void BasicBlock::accept(Visitor& visitor) {
     visitor.visit(*this); 
 }
 
+std::string BlockLabel::str() const {
+    std::ostringstream out;
+    out << *this;
+    return out.str();
+}
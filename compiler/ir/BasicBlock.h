@@ -1,26 +1,56 @@
 #pragma once
 
+#include "../StringInterner.h"
+#include "Arena.h"
 #include "Instructions.h"
 #include <memory>
+#include <ostream>
+#include <string>
 #include <vector>
-#include <sstream>
 
 namespace ir {
     class Terminator;
     class BasicBlock;
 
+    // Label of a block, only turned into text when printed : .<function>.BB<number>, .<function>.prologue
+    // or .<function>.epilogue
+    struct BlockLabel {
+        static constexpr uint32_t PROLOGUE = UINT32_MAX - 1;
+        static constexpr uint32_t EPILOGUE = UINT32_MAX;
+
+        Symbol function;
+        uint32_t number;
+
+        bool operator==(const BlockLabel&) const = default;
+
+        std::string str() const;
+
+        // Out is an std::ostream or the AsmBuffer of the code generation
+        template <class Out>
+        friend Out& operator<<(Out& out, const BlockLabel& self) {
+            out << "." << globalSymbols.text(self.function);
+            switch (self.number) {
+                case PROLOGUE: out << ".prologue"; break;
+                case EPILOGUE: out << ".epilogue"; break;
+                default: out << ".BB" << self.number;
+            }
+            return out;
+        }
+    };
+
     // A block in the ControlFlowGraph
     // It's composed of a list of Instruction and a Terminator
     // The Terminator is null if the block is the epilogue or if it's still in construction
     class BasicBlock : public Visitable {
       public:
-        BasicBlock(const std::string& functionName, uint32_t id) {
-            std::stringstream labelStream;
-            labelStream << "." << functionName << ".BB" << id; 
-            m_label = labelStream.str();
-        }
+        BasicBlock(Arena& arena, BlockLabel label) : m_arena(arena), m_label(label) {}
 
-        BasicBlock(const std::string& customLabel) : m_label(customLabel) {
+        // Construct an instruction of type InstructionT in the function arena without adding it to the block.
+        // Used by passes replacing an instruction by another one.
+        template <class InstructionT, class... Args>
+            requires std::derived_from<InstructionT, Instruction>
+        InstructionT* allocate(Args&&... args) {
+            return m_arena.create<InstructionT>(std::forward<Args>(args)...);
         }
 
         // Append an instruction of type InstructionT to the block and return a pointer to it.
@@ -28,16 +58,9 @@ namespace ir {
         template <class InstructionT, class... Args>
             requires std::derived_from<InstructionT, Instruction>
         InstructionT* emit(Args&&... args) {
-            // Create a unique pointer to the Instruction
-            std::unique_ptr<InstructionT> unique = std::make_unique<InstructionT>(std::forward<Args>(args)...);
-
-            // Get a basic pointer from it to return it
-            InstructionT* ptr = unique.get();
-
-            // Move our unique pointer to the vector.
-            // std::move is required because unique_ptr can't be copied as this would result
-            // in use after free errors
-            m_instructions.push_back(std::move(unique));
+            // The instruction is owned by the arena, the block only keeps a pointer to it
+            InstructionT* ptr = allocate<InstructionT>(std::forward<Args>(args)...);
+            m_instructions.push_back(ptr);
             return ptr;
         }
 
@@ -46,23 +69,21 @@ namespace ir {
         template <class TerminatorT, class... Args>
             requires std::derived_from<TerminatorT, Terminator>
         TerminatorT* terminate(Args&&... args) {
-            // Create a unique_ptr to the actual type
-            std::unique_ptr<TerminatorT> unique = std::make_unique<TerminatorT>(std::forward<Args>(args)...);
-
-            // Get the pointer from it
-            TerminatorT* ptr = unique.get();
-
-            // Move the pointer to the member, upcasting it
-            m_terminator = std::move(unique);
-
+            TerminatorT* ptr = m_arena.create<TerminatorT>(std::forward<Args>(args)...);
+            m_terminator = ptr;
             return ptr;
         }
 
-        void terminate(std::unique_ptr<Terminator>&& terminator) {
-            m_terminator = std::move(terminator);
+        // Terminate the block with an already allocated Terminator (which must come from the same arena)
+        void terminate(Terminator* terminator) {
+            m_terminator = terminator;
         }
 
-        const std::string& label() const { return m_label; }
+        BlockLabel label() const { return m_label; }
+
+        // Dense index of the block inside its function, see Function::indexBlocks
+        uint32_t index() const { return m_index; }
+        void setIndex(uint32_t index) { m_index = index; }
 
         auto& instructions() { return m_instructions; }
         const auto& instructions() const { return m_instructions; }
@@ -78,10 +99,16 @@ namespace ir {
         }
 
       private:
-        std::vector<std::unique_ptr<Instruction>> m_instructions;
-        std::unique_ptr<Terminator> m_terminator;
+        // Arena of the function owning this block, every Instruction and Terminator lives in it
+        Arena& m_arena;
+
+        // Non-owning pointers into the arena
+        std::vector<Instruction*> m_instructions;
+        Terminator* m_terminator = nullptr;
 
         // Unique label of the block
-        std::string m_label;
+        BlockLabel m_label;
+
+        uint32_t m_index = 0;
     };
 }
@@ -4,7 +4,7 @@
 #include "Visitable.h"
 #include <algorithm>
 #include <optional>
-#include <sstream>
+#include <string_view>
 
 namespace ir {
 
@@ -29,17 +29,16 @@ namespace ir {
     // Represents a function in a form of a ControlFlowGraph
     class Function : public Visitable {
       public:
-        Function(const std::string& name, size_t argCount, const Type* returnType) :
-            m_name(name), m_argCount(argCount), m_locals({LocalInfo(returnType)}),
-            m_prologue(generatePrologueLabel(name)), m_epilogue(generateEpilogueLabel(name)) {}
+        Function(std::string_view name, size_t argCount, const Type* returnType) :
+            m_name(globalSymbols.intern(name)), m_argCount(argCount), m_locals({LocalInfo(returnType)}),
+            m_prologue(m_arena, {m_name, BlockLabel::PROLOGUE}), m_epilogue(m_arena, {m_name, BlockLabel::EPILOGUE}) {}
 
         Function(
-            const std::string& name, std::initializer_list<const Type*> argTypes, const Type* returnType,
+            std::string_view name, std::initializer_list<const Type*> argTypes, const Type* returnType,
             bool variadic = false
         ) :
-            m_name(name),
-            m_argCount(argTypes.size()), m_variadic(variadic), m_prologue(generatePrologueLabel(name)),
-            m_epilogue(generateEpilogueLabel(name)) {
+            m_name(globalSymbols.intern(name)), m_argCount(argTypes.size()), m_variadic(variadic),
+            m_prologue(m_arena, {m_name, BlockLabel::PROLOGUE}), m_epilogue(m_arena, {m_name, BlockLabel::EPILOGUE}) {
             m_locals.emplace_back(returnType);
             std::transform(std::begin(argTypes), std::end(argTypes), std::back_inserter(m_locals), [](auto type) {
                 return LocalInfo(type);
@@ -48,7 +47,7 @@ namespace ir {
 
         // Allocate a new BasicBlock for this function
         BasicBlock* newBlock() {
-            m_blocks.push_back(std::make_unique<BasicBlock>(m_name, m_blocks.size()));
+            m_blocks.push_back(std::make_unique<BasicBlock>(m_arena, BlockLabel{m_name, uint32_t(m_blocks.size())}));
             return m_blocks.back().get();
         }
 
@@ -69,22 +68,11 @@ namespace ir {
             return Local{id, type};
         }
 
-        StringLiteral newLiteral(std::string literal) {
-            for (size_t i = 0; i < m_literals.size(); i++) {
-                if (literal == m_literals[i]) {
-                    return StringLiteral(i);
-                }
-            }
-
-            StringLiteral res(m_literals.size());
-            m_literals.push_back(std::move(literal));
-            return res;
-        }
-
         Local returnLocal() const { return Local{0, m_locals.at(0).type()}; }
         Local invalidLocal() const { return Local{INT32_MAX, types::VOID}; }
 
-        const auto& name() const { return m_name; }
+        const std::string& name() const { return globalSymbols.text(m_name); }
+        Symbol symbol() const { return m_name; }
 
         bool variadic() const { return m_variadic; }
 
@@ -93,14 +81,41 @@ namespace ir {
         const auto& blocks() const { return m_blocks; }
         auto& blocks() { return m_blocks; }
 
+        // Give every block a dense index usable to store per block data in a vector :
+        // 0 for the prologue, 1 to n for the blocks and n + 1 for the epilogue.
+        // Return the number of indexed blocks.
+        size_t indexBlocks() {
+            m_prologue.setIndex(0);
+            for (size_t i = 0; i < m_blocks.size(); i++) {
+                m_blocks[i]->setIndex(i + 1);
+            }
+            m_epilogue.setIndex(m_blocks.size() + 1);
+            return m_blocks.size() + 2;
+        }
+
         const auto& locals() const { return m_locals; }
         auto& locals() { return m_locals; }
 
-        const auto& literals() const { return m_literals; }
-        auto& literals() { return m_literals; }
+        const Arena& arena() const { return m_arena; }
+
+        // Free every Instruction and Terminator of the function at once, and the locals other than the return
+        // variable and the arguments. Only the declaration is still usable afterwards.
+        void releaseArena() {
+            if (m_locals.size() > m_argCount + 1) {
+                m_locals.erase(m_locals.begin() + m_argCount + 1, m_locals.end());
+                m_locals.shrink_to_fit();
+            }
+            m_blocks.clear();
+            m_blocks.shrink_to_fit();
+            m_prologue.instructions().clear();
+            m_prologue.terminate(nullptr);
+            m_epilogue.instructions().clear();
+            m_epilogue.terminate(nullptr);
+            m_arena.release();
+        }
 
         void printLocalMapping(std::ostream& out) const {
-            out << "debug " << m_name << " {" << std::endl;
+            out << "debug " << name() << " {" << std::endl;
             for (size_t i = 0; i < m_locals.size(); i++) {
                 if (!m_locals[i].isTemporary())
                     out << "    _" << i << " => " << m_locals[i].name().value() << std::endl;
@@ -112,34 +127,23 @@ namespace ir {
 
       private:
         // The function name
-        std::string m_name;
+        Symbol m_name;
 
         // Number of arguments this function has
         size_t m_argCount;
 
+        // Owns every Instruction and Terminator of the function. Declared before the blocks so it outlives them
+        Arena m_arena;
+
         // Information about all local variables. Always at least (m_argCount + 1) elements : the return variable _0 and the arguments _1 to _m_argCount
         std::vector<LocalInfo> m_locals;
 
         // Allocated on the heap to not invalidate pointers to BasicBlocks when resizing the vector
         std::vector<std::unique_ptr<BasicBlock>> m_blocks;
 
-        std::vector<std::string> m_literals;
-
         bool m_variadic = false;
 
         BasicBlock m_prologue;
         BasicBlock m_epilogue;
-
-        static std::string generatePrologueLabel(const std::string& functionName) {
-            std::stringstream ss;
-            ss << "." << functionName << ".prologue";
-            return ss.str();
-        }
-
-        static std::string generateEpilogueLabel(const std::string& functionName) {
-            std::stringstream ss;
-            ss << "." << functionName << ".epilogue";
-            return ss.str();
-        }
     };
 }
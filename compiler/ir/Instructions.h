@@ -1,5 +1,6 @@
 #pragma once
 
+#include "../StringInterner.h"
 #include "../Type.h"
 #include "Visitable.h"
 #include <cassert>
@@ -107,6 +108,8 @@ namespace ir {
         BIT_AND,
         BIT_XOR,
         BIT_OR,
+        // Only emitted by the front end, to scale the index of pointer arithmetic
+        SHL,
     };
 
     inline std::ostream& operator<<(std::ostream& out, const BinaryOpKind& op) {
@@ -125,6 +128,7 @@ namespace ir {
             case BinaryOpKind::BIT_AND: return out << "&";
             case BinaryOpKind::BIT_XOR: return out << "^";
             case BinaryOpKind::BIT_OR: return out << "|";
+            case BinaryOpKind::SHL: return out << "<<";
         }
         return out;
     }
@@ -216,11 +220,11 @@ namespace ir {
 
     class Call : public Instruction {
       public:
-        Call(const Local& destination, std::string name, std::vector<RValue> args, bool variadic = false) :
-            Instruction(), m_destination(destination), m_name(std::move(name)), m_args(std::move(args)), m_variadic(variadic) {}
+        Call(const Local& destination, Symbol name, std::vector<RValue> args, bool variadic = false) :
+            Instruction(), m_destination(destination), m_name(name), m_args(std::move(args)), m_variadic(variadic) {}
 
         void print(std::ostream& out) const override {
-            out << m_destination << " := " << m_name << "(";
+            out << m_destination << " := " << name() << "(";
             bool first = true;
             for (auto& arg : m_args) {
                 if (!first)
@@ -234,7 +238,8 @@ namespace ir {
         const Local& destination() const { return m_destination; }
         Local& destination() { return m_destination; }
 
-        const auto& name() const { return m_name; }
+        const std::string& name() const { return globalSymbols.text(m_name); }
+        Symbol symbol() const { return m_name; }
 
         const auto& args() const { return m_args; }
         auto& args() { return m_args; }
@@ -245,7 +250,8 @@ namespace ir {
 
       private:
         Local m_destination;
-        std::string m_name;
+        // Name of the callee
+        Symbol m_name;
         std::vector<RValue> m_args;
         bool m_variadic;
     };
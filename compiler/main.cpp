@@ -1,25 +1,32 @@
+#include <algorithm>
+#include <charconv>
+#include <chrono>
 #include <iostream>
 #include <fstream>
+#include <iomanip>
 #include <optional>
 #include <sstream>
 #include <cstdlib>
+#include <filesystem>
 #include <string_view>
+#include <thread>
 #include <variant>
+#include <vector>
 
-#include "BlockDependance.h"
-#include "BlockLivenessAnalysis.h"
-#include "BlockReordering.h"
-#include "ConstantFolding.h"
-#include "DeadCodeElimination.h"
-#include "EmptyBlockElimination.h"
+#include "BackgroundWriter.h"
+#include "CompileReport.h"
+#include "CompileServer.h"
+#include "DfaLexer.h"
+#include "ElfWriter.h"
+#include "IrBuilder.h"
 #include "IrGenVisitor.h"
+#include "IrParser.h"
 #include "IrPrintVisitor.h"
 #include "IrGraphVisitor.h"
-#include "IrValuePropagationVisitor.h"
-#include "BlockDependance.h"
 #include "LocalRenaming.h"
-#include "PointedLocalGatherer.h"
-#include "TwoStepAssignmentElimination.h"
+#include "Parallel.h"
+#include "PassManager.h"
+#include "SourceFile.h"
 #include "Type.h"
 #include "X86GenVisitor.h"
 #include "antlr4-runtime.h"
@@ -31,110 +38,686 @@
 using namespace antlr4;
 using namespace std;
 
-static void performOptimizations(ir::Function& function) {
-        bool changed;
-        do {
-            PointedLocals pointedLocals = computePointedLocals(function);
+// Parse with SLL prediction first, it is much faster than full LL and is enough for nearly every program.
+// SLL can only fail on a valid program for some ambiguous inputs, so on the first error we parse again
+// with full LL which also reports the real syntax errors.
+static tree::ParseTree* parse(
+    ifccParser& parser, CommonTokenStream& tokens, ANTLRErrorListener& errorListener, CompileReport* report
+) {
+    auto interpreter = parser.getInterpreter<atn::ParserATNSimulator>();
+    {
+        CompileReport::Scope scope(report, "parsing");
+        interpreter->setPredictionMode(atn::PredictionMode::SLL);
+        parser.removeErrorListeners();
+        parser.setErrorHandler(std::make_shared<BailErrorStrategy>());
+        try {
+            return parser.axiom();
+        } catch (ParseCancellationException&) {
+        }
+    }
 
-            IrValuePropagationVisitor propagator{pointedLocals};
-            propagator.visit(function);
+    CompileReport::Scope scope(report, "parsing (LL fallback)");
+    tokens.reset();
+    parser.reset();
+    parser.addErrorListener(&errorListener);
+    parser.setErrorHandler(std::make_shared<DefaultErrorStrategy>());
+    interpreter->setPredictionMode(atn::PredictionMode::LL);
+    return parser.axiom();
+}
 
-            DependanceMap dependanceMap = computeDependanceMap(function);
-            BlockLivenessAnalysis livenessAnalysis = computeBlockLivenessAnalysis(function, dependanceMap);
+// Print every token with its position, type, text and range in the input, hidden tokens included
+static void printTokens(CommonTokenStream& tokens, const dfa::Vocabulary& vocabulary, ostream& out) {
+    for (Token* token : tokens.getTokens()) {
+        out << token->getLine() << ":" << token->getCharPositionInLine() << " "
+            << vocabulary.getDisplayName(token->getType()) << " '";
+        for (char c : token->getText()) {
+            switch (c) {
+                case '\n': out << "\\n"; break;
+                case '\t': out << "\\t"; break;
+                case '\r': out << "\\r"; break;
+                default: out << c; break;
+            }
+        }
+        out << "' [" << token->getStartIndex() << "," << ssize_t(token->getStopIndex()) << "]";
+        if (token->getChannel() != Token::DEFAULT_CHANNEL) {
+            out << " channel " << token->getChannel();
+        }
+        out << "\n";
+    }
+}
 
-            DeadCodeElimination deadCodeElimination{livenessAnalysis, pointedLocals};
-            deadCodeElimination.visit(function);
+// Print the prediction statistics of every decision of the grammar used during parsing, slowest first
+static void printParseProfile(ifccParser& parser, ostream& out) {
+    auto decisionInfo = parser.getParseInfo().getDecisionInfo();
+    vector<const atn::DecisionInfo*> decisions;
+    for (const auto& decision : decisionInfo) {
+        if (decision.invocations > 0) {
+            decisions.push_back(&decision);
+        }
+    }
+    std::sort(decisions.begin(), decisions.end(), [](auto* a, auto* b) {
+        return a->timeInPrediction > b->timeInPrediction;
+    });
 
-            ConstantFoldingVisitor folding;
-            folding.visit(function);
+    out << "Parse profile (" << decisions.size() << " decisions used)\n";
+    out << left << setw(10) << "decision" << setw(18) << "rule" << right;
+    for (auto column : {"invocations", "time (us)", "SLL look", "SLL max", "LL fallback", "LL look", "LL max"}) {
+        out << setw(13) << column;
+    }
+    out << "\n";
 
-            livenessAnalysis = computeBlockLivenessAnalysis(function, dependanceMap);
-            TwoStepAssignmentEliminationVisitor elimination{livenessAnalysis, pointedLocals};
-            elimination.visit(function);
+    for (auto* decision : decisions) {
+        const auto& rule = parser.getRuleNames()[parser.getATN().decisionToState[decision->decision]->ruleIndex];
+        out << left << setw(10) << decision->decision << setw(18) << rule << right << setw(13)
+            << decision->invocations << setw(13) << decision->timeInPrediction / 1000 << setw(13)
+            << decision->SLL_TotalLook << setw(13) << decision->SLL_MaxLook << setw(13) << decision->LL_Fallback
+            << setw(13) << decision->LL_TotalLook << setw(13) << decision->LL_MaxLook << "\n";
+    }
+}
 
-            // Recompute dependance map as it may have changed
-            dependanceMap = computeDependanceMap(function);
+// Print the syntax errors found by ANTLR like ConsoleErrorListener, but to the log of the compiled file
+class LogErrorListener : public BaseErrorListener {
+  public:
+    explicit LogErrorListener(ostream& log) : m_log(log) {}
 
-            EmptyBlockEliminationVisitor emptyBlockElimination{dependanceMap};
-            emptyBlockElimination.visit(function);
+    void syntaxError(
+        Recognizer*, Token*, size_t line, size_t charPositionInLine, const std::string& msg, std::exception_ptr
+    ) override {
+        m_log << "line " << line << ":" << charPositionInLine << " " << msg << endl;
+    }
 
-            BlockReorderingVisitor blockReordering;
-            blockReordering.visit(function);
+  private:
+    ostream& m_log;
+};
 
-            changed = propagator.changed() || deadCodeElimination.changed() || folding.changed() ||
-                emptyBlockElimination.changed() || blockReordering.changed() || elimination.changed();
-        } while (changed);
-}
+// Options of the command line, the same for every compiled file
+struct Options {
+    bool optimize = true;
+    // Print the IR of each function to stderr
+    bool dumpIr = false;
+    // Directory of the .dot graph of each function, empty when they are not written
+    std::string dumpCfgDir;
+    // Print the progress of the code generation
+    bool verbose = false;
+    bool memStats = false;
+    bool parseProfile = false;
+    bool dfaLexer = false;
+    bool dumpTokens = false;
+    bool fastFrontend = false;
+    bool streaming = false;
+    // Write a relocatable object instead of the assembly (-c)
+    bool object = false;
+    // Other files may be compiled by the process at the same time, the type pool and the symbols are never frozen
+    bool concurrent = false;
+    // Number of threads compiling the functions of a file
+    unsigned jobs = 1;
+    PassManager* passManager = nullptr;
+    // Writes the graphs without blocking the compilation, they are written by the compiling thread when it is null.
+    // The IR is printed to the log of the file, in order with its diagnostics
+    BackgroundWriter* dumpWriter = nullptr;
+};
 
-int main(int argn, const char** argv) {
-    stringstream in;
-    if (argn >= 2) {
-        ifstream lecture(argv[1]);
-        if (!lecture.good()) {
-            cerr << "error: cannot read file: " << argv[1] << endl;
-            exit(1);
-        }
-        in << lecture.rdbuf();
+// Compile source, write its assembly (or its object with -c) to out and its diagnostics to log. The graph of each
+// function is written to <dumpCfgDir>/<dotPrefix><function>.dot. Return the exit status of the compilation of this file
+static int compileSource(
+    const SourceFile& source, const std::string& dotPrefix, const Options& options, ostream& out, ostream& log,
+    CompileReport* measuredReport
+) {
+    if (!options.dumpCfgDir.empty()) {
+        std::error_code error;
+        std::filesystem::create_directories(options.dumpCfgDir, error);
+        if (error) {
+            log << "error: cannot create directory " << options.dumpCfgDir << ": " << error.message() << endl;
+            return 1;
+        }
+    }
+
+    // The lexer reads the mapped file directly
+    SourceCharStream input(source.text(), source.name());
+
+    // The ATN and the DFA cache of the generated lexer and parser are static, they are built by the first file
+    // and shared by the following ones
+    LogErrorListener errorListener(log);
+    ifccLexer lexer(&input);
+    lexer.removeErrorListeners();
+    lexer.addErrorListener(&errorListener);
+    DfaLexer handWrittenLexer(input, lexer.getVocabulary(), log);
+    TokenSource* tokenSource = options.dfaLexer ? static_cast<TokenSource*>(&handWrittenLexer) : &lexer;
+    CommonTokenStream tokens(tokenSource);
+
+    // In streaming mode the parser pulls the tokens itself
+    if (!options.streaming || options.dumpTokens) {
+        CompileReport::Scope scope(measuredReport, "lexing");
+        tokens.fill();
+    }
+
+    if (options.dumpTokens) {
+        printTokens(tokens, lexer.getVocabulary(), out);
+        return 0;
+    }
+
+    // With -c the machine code of every function is kept until the object is written
+    std::optional<ElfWriter> object;
+    if (options.object) {
+        object.emplace();
+    }
+
+    // The assembly of the function is printed to out, or its machine code is stored in code with -c
+    auto compileFunction = [&](ir::Function& function, ostream& out, MachineCode* code, ostream& log,
+                               CompileReport* report) {
+        auto start = chrono::steady_clock::now();
+
+        if (options.optimize) {
+            options.passManager->run(function, report);
+        }
+
+        {
+            CompileReport::Scope scope(report, "local renaming");
+            LocalRenamingVisitor localRenaming;
+            localRenaming.visit(function);
+        }
+
+        // The dumps are formatted before the function is released. The log is a buffer, or a BackgroundLog when
+        // it goes to the terminal
+        if (options.dumpIr) {
+            CompileReport::Scope scope(report, "ir dump");
+            IrPrintVisitor printer(log);
+            printer.visit(function);
+            log.flush();
+        }
+
+        if (!options.dumpCfgDir.empty()) {
+            CompileReport::Scope scope(report, "cfg dump");
+            stringstream text;
+            IrGraphVisitor cfg(text);
+            cfg.visit(function);
+            std::string path =
+                (std::filesystem::path(options.dumpCfgDir) / (dotPrefix + function.name() + ".dot")).string();
+            if (options.dumpWriter) {
+                options.dumpWriter->writeFile(std::move(path), std::move(text).str());
+            } else {
+                ofstream(path) << text.view();
+            }
+        }
+
+        std::ostream* progressLog = options.verbose ? &log : nullptr;
+        X86GenVisitor gen = code ? X86GenVisitor(*code, options.optimize, progressLog, report)
+                                 : X86GenVisitor(out, options.optimize, progressLog, report);
+        gen.visit(function);
+
+        if (options.memStats) {
+            const auto& arena = function.arena();
+            log << function.name() << ": arena used " << arena.bytesUsed() << " bytes (" << arena.bytesReserved()
+                << " bytes reserved in " << arena.chunkCount() << " chunks)" << endl;
+        }
+
+        // The function has been lowered, its instructions are no longer needed
+        function.releaseArena();
+
+        if (report) {
+            report->addFunction(function.name(), chrono::steady_clock::now() - start);
+        }
+    };
+
+    IrBuilder builder(log);
+
+    if (options.streaming) {
+        // Each function is compiled and released as soon as it is parsed. Only its declaration is kept for the
+        // calls of the following functions
+        IrParser irParser(*tokenSource, source.text(), lexer.getVocabulary(), builder);
+        while (true) {
+            IrParser::Status status;
+            {
+                CompileReport::Scope scope(measuredReport, "parsing + ir generation");
+                status = irParser.parseNextFunction();
+            }
+            if (status == IrParser::Status::SYNTAX_ERROR) {
+                log << "error: syntax error during parsing" << endl;
+                return 1;
+            }
+            if (status == IrParser::Status::END) {
+                break;
+            }
+
+            // The assembly of the previous functions has already been printed
+            if (builder.hasErrors()) {
+                log << "Des erreurs sont survenues. Abandon." << endl;
+                return 1;
+            }
+            MachineCode code;
+            compileFunction(*builder.functions().back(), out, object ? &code : nullptr, log, measuredReport);
+            if (object) {
+                object->addFunction(code);
+            }
+        }
+    } else if (options.fastFrontend) {
+        // The IR is emitted while parsing, there is no parse tree
+        CompileReport::Scope scope(measuredReport, "parsing + ir generation");
+        IrParser irParser(tokens.getTokens(), source.text(), lexer.getVocabulary(), builder);
+        if (!irParser.parse()) {
+            log << "error: syntax error during parsing" << endl;
+            return 1;
+        }
     } else {
-        cerr << "usage: ifcc path/to/file.c" << endl;
-        exit(1);
+        ifccParser parser(&tokens);
+        parser.setProfile(options.parseProfile);
+        tree::ParseTree* tree = parse(parser, tokens, errorListener, measuredReport);
+
+        if (options.parseProfile) {
+            printParseProfile(parser, log);
+        }
+
+        if (parser.getNumberOfSyntaxErrors() != 0) {
+            log << "error: syntax error during parsing" << endl;
+            return 1;
+        }
+
+        IrGenVisitor visitor(builder);
+        CompileReport::Scope scope(measuredReport, "ir generation");
+        visitor.visit(tree);
     }
 
-    bool optimize = true;
-    bool silent = false;
-    for (int i = 1; i < argn; i++) {
-        std::string_view arg = argv[i];
-        if (arg == "-O0") {
-            optimize = false;
+    if (builder.hasErrors()) {
+
+        log << "Des erreurs sont survenues. Abandon." << endl;
+        return 1;
+    }
+
+    // Functions are independent from now on and the backend never creates new types or symbols. The other files
+    // may still be in their front end
+    if (!options.concurrent) {
+        globalTypePool.freeze();
+        globalSymbols.freeze();
+    }
+
+    auto& functions = builder.functions();
+    if (options.streaming) {
+        // Every function has already been compiled
+    } else if (options.jobs == 1) {
+        for (auto& function : functions) {
+            MachineCode code;
+            compileFunction(*function, out, object ? &code : nullptr, log, measuredReport);
+            if (object) {
+                object->addFunction(code);
+            }
+        }
+    } else {
+        // Each function is written in its own buffers which are printed in source order,
+        // so the output is the same as the one of a serial run
+        vector<stringstream> asmBuffers(functions.size());
+        vector<MachineCode> codes(object ? functions.size() : 0);
+        vector<stringstream> logBuffers(functions.size());
+        // A report is not thread safe, every function gets its own
+        vector<CompileReport> functionReports(measuredReport ? functions.size() : 0);
+        parallelFor(functions.size(), options.jobs, [&](size_t i) {
+            compileFunction(
+                *functions[i], asmBuffers[i], object ? &codes[i] : nullptr, logBuffers[i],
+                measuredReport ? &functionReports[i] : nullptr
+            );
+        });
+
+        for (size_t i = 0; i < functions.size(); i++) {
+            log << logBuffers[i].view();
+            if (object) {
+                object->addFunction(codes[i]);
+            } else {
+                out << asmBuffers[i].view();
+            }
+        }
+
+        for (const auto& functionReport : functionReports) {
+            measuredReport->merge(functionReport);
+        }
+    }
+
+    if (object) {
+        CompileReport::Scope scope(measuredReport, "write object");
+        object->write(out, builder.literals());
+    } else {
+        X86GenVisitor::printLiterals(out, builder.literals());
+    }
+    return 0;
+}
+
+static int compileFile(
+    const std::string& path, const std::string& dotPrefix, const Options& options, ostream& out, ostream& log,
+    CompileReport* measuredReport
+) {
+    // "-" reads the program from stdin
+    std::optional<SourceFile> source = SourceFile::open(path);
+    if (!source) {
+        log << "error: cannot read file: " << path << endl;
+        return 1;
+    }
+    return compileSource(*source, dotPrefix, options, out, log, measuredReport);
+}
+
+// Everything given on the command line
+struct CommandLine {
+    Options options;
+    bool timeReport = false;
+    bool memReport = false;
+    // Number of functions listed by -ftime-report
+    size_t slowestFunctions = 10;
+    unsigned jobs = 1;
+    vector<std::string> inputs;
+    std::string outputFile;
+    std::string outputDir;
+    // Unix socket of --server or --client
+    std::string server;
+    std::string client;
+    // Options sent by --client to the server: everything but the inputs, the outputs and --client
+    vector<std::string> forwarded;
+    std::optional<PassManager> passManager = PassManager::defaultPipeline();
+};
+
+// Return false after printing the error to log if an argument is invalid
+static bool parseCommandLine(const vector<std::string>& args, CommandLine& commandLine, ostream& log) {
+    Options& options = commandLine.options;
+    for (size_t i = 0; i < args.size(); i++) {
+        std::string_view arg = args[i];
+        bool forwarded = true;
+        if (arg == "-j" || (arg.starts_with("-j") && arg.size() > 2)) {
+            std::string_view value =
+                arg.size() > 2 ? arg.substr(2) : (i + 1 < args.size() ? std::string_view(args[++i]) : "");
+            auto [end, error] = std::from_chars(value.data(), value.data() + value.size(), commandLine.jobs);
+            if (error != std::errc() || end != value.data() + value.size()) {
+                log << "error: invalid job count: " << value << endl;
+                return false;
+            }
+            // -j 0 uses every core
+            if (commandLine.jobs == 0) {
+                commandLine.jobs = std::max(1u, std::thread::hardware_concurrency());
+            }
+            commandLine.forwarded.push_back("-j" + std::string(value));
+            forwarded = false;
+        } else if (arg == "-o" || arg == "-output-dir" || arg == "--server" || arg == "--client") {
+            if (i + 1 >= args.size()) {
+                log << "error: missing argument to " << arg << endl;
+                return false;
+            }
+            std::string& value = arg == "-o"            ? commandLine.outputFile
+                                 : arg == "-output-dir" ? commandLine.outputDir
+                                 : arg == "--server"    ? commandLine.server
+                                                        : commandLine.client;
+            value = args[++i];
+            forwarded = false;
+        } else if (arg == "-c") {
+            options.object = true;
+        } else if (arg == "-O0") {
+            options.optimize = false;
         } else if (arg == "-s") {
-            silent = true;
+            // Nothing is dumped without -dump-ir or -dump-cfg, -s is kept for the existing scripts
+        } else if (arg == "-dump-ir") {
+            options.dumpIr = true;
+        } else if (arg.starts_with("-dump-cfg=")) {
+            options.dumpCfgDir = arg.substr(std::string_view("-dump-cfg=").size());
+        } else if (arg == "-v") {
+            options.verbose = true;
+        } else if (arg == "-fmem-stats") {
+            options.memStats = true;
+        } else if (arg == "-ftime-report" || arg.starts_with("-ftime-report=")) {
+            commandLine.timeReport = true;
+            if (arg.size() > std::string_view("-ftime-report").size()) {
+                std::string_view value = arg.substr(std::string_view("-ftime-report=").size());
+                auto [end, error] =
+                    std::from_chars(value.data(), value.data() + value.size(), commandLine.slowestFunctions);
+                if (error != std::errc() || end != value.data() + value.size()) {
+                    log << "error: invalid function count: " << value << endl;
+                    return false;
+                }
+            }
+        } else if (arg == "-fmem-report") {
+            commandLine.memReport = true;
+        } else if (arg == "-fparse-profile") {
+            options.parseProfile = true;
+        } else if (arg == "-fdfa-lexer") {
+            options.dfaLexer = true;
+        } else if (arg == "-dump-tokens") {
+            options.dumpTokens = true;
+        } else if (arg == "-ffast-frontend") {
+            options.fastFrontend = true;
+        } else if (arg == "-fstreaming") {
+            options.streaming = true;
+        } else if (arg.starts_with("-passes=")) {
+            commandLine.passManager = PassManager::parse(arg.substr(std::string_view("-passes=").size()), log);
+            if (!commandLine.passManager) {
+                return false;
+            }
+        } else if (arg == "-" || !arg.starts_with("-")) {
+            commandLine.inputs.emplace_back(arg);
+            forwarded = false;
+        }
+
+        if (forwarded) {
+            commandLine.forwarded.emplace_back(arg);
         }
     }
 
-    ANTLRInputStream input(in.str());
+    options.passManager = &*commandLine.passManager;
+    return true;
+}
 
-    ifccLexer lexer(&input);
-    CommonTokenStream tokens(&lexer);
+// Compile a request of a client in the process of the server
+static CompileResponse serveRequest(const CompileRequest& request) {
+    CompileResponse response;
+    stringstream out;
+    stringstream log;
+    CommandLine commandLine;
+    if (!parseCommandLine(request.args, commandLine, log)) {
+        return {1, "", log.str()};
+    }
+
+    Options& options = commandLine.options;
+    options.concurrent = true;
+    options.jobs = commandLine.jobs;
+    CompileReport report;
+    bool measured = commandLine.timeReport || commandLine.memReport;
+    if (commandLine.memReport) {
+        // The allocations of the server are counted from the first request which asks for them
+        countAllocations();
+    }
+    SourceFile source = SourceFile::fromText(request.name, request.source);
+    try {
+        // The IR is sent back with the diagnostics. The graphs are written by the server, relative to its working
+        // directory
+        response.status = compileSource(source, "", options, out, log, measured ? &report : nullptr);
+    } catch (const std::exception& error) {
+        // The server keeps answering the other requests
+        log << "error: internal compiler error: " << error.what() << endl;
+        response.status = 1;
+    }
+
+    if (response.status == 0 && commandLine.timeReport) {
+        report.printTimes(log, commandLine.slowestFunctions);
+    }
+    if (response.status == 0 && commandLine.memReport) {
+        report.printMemory(log);
+    }
+
+    response.assembly = out.str();
+    response.diagnostics = log.str();
+    return response;
+}
+
+// Send the file at path to the server of --client and write its response to out and log
+static int compileRemotely(const CommandLine& commandLine, const std::string& path, ostream& out, ostream& log) {
+    std::optional<SourceFile> source = SourceFile::open(path);
+    if (!source) {
+        log << "error: cannot read file: " << path << endl;
+        return 1;
+    }
 
-    tokens.fill();
+    CompileRequest request{commandLine.forwarded, source->name(), std::string(source->text())};
+    std::optional<CompileResponse> response = sendRequest(commandLine.client, request, log);
+    if (!response) {
+        return 1;
+    }
 
-    ifccParser parser(&tokens);
-    tree::ParseTree* tree = parser.axiom();
+    out << response->assembly;
+    log << response->diagnostics;
+    return response->status;
+}
 
-    if (parser.getNumberOfSyntaxErrors() != 0) {
-        cerr << "error: syntax error during parsing" << endl;
+int main(int argn, const char** argv) {
+    CommandLine commandLine;
+    if (!parseCommandLine(vector<std::string>(argv + 1, argv + argn), commandLine, cerr)) {
         exit(1);
     }
-    globalTypePool.init();
 
-    IrGenVisitor visitor;
-    visitor.visit(tree);
+    Options& options = commandLine.options;
+    const auto& inputs = commandLine.inputs;
+    const auto& outputFile = commandLine.outputFile;
+    const auto& outputDir = commandLine.outputDir;
+    bool remote = !commandLine.client.empty();
+
+    globalTypePool.init();
 
-    if (visitor.hasErrors()) {
+    // Destroyed after every file has been compiled, once every dump is written
+    std::optional<BackgroundWriter> dumpWriter;
+    if (options.dumpIr || !options.dumpCfgDir.empty()) {
+        options.dumpWriter = &dumpWriter.emplace();
+    }
 
-        cerr << "Des erreurs sont survenues. Abandon." << endl;
+    if (!commandLine.server.empty()) {
+        // The ATN and the DFA cache of ANTLR are static, they stay warm from one request to the next
+        runServer(commandLine.server, serveRequest, cerr);
         return 1;
     }
 
-    IrPrintVisitor printer(cerr);
-    X86GenVisitor gen(cout, optimize);
-    for (auto& function : visitor.functions()) {
-        ofstream file(function->name() + ".dot");
-        IrGraphVisitor cfg(file);
+    if (inputs.empty()) {
+        cerr << "usage: ifcc [options] path/to/file.c..." << endl;
+        exit(1);
+    }
+    if (!outputFile.empty() && (!outputDir.empty() || inputs.size() > 1)) {
+        cerr << "error: -o needs a single input file, use -output-dir to compile several files" << endl;
+        exit(1);
+    }
+
+    options.concurrent = inputs.size() > 1;
 
-        if (optimize) {
-            performOptimizations(*function);
+    // Where the assembly of each input is written, empty for stdout. A single file is printed on stdout unless
+    // an output is given, the files of a batch are written to file.s (file.o with -c) next to file.c or in the
+    // output directory
+    vector<std::filesystem::path> outputs(inputs.size());
+    for (size_t i = 0; i < inputs.size(); i++) {
+        if (!outputFile.empty()) {
+            outputs[i] = outputFile;
+        } else if (options.concurrent || !outputDir.empty()) {
+            if (inputs[i] == "-") {
+                cerr << "error: the output of stdin needs a name, use -o" << endl;
+                exit(1);
+            }
+            std::filesystem::path name =
+                std::filesystem::path(inputs[i]).replace_extension(options.object ? ".o" : ".s");
+            outputs[i] = !outputDir.empty() ? std::filesystem::path(outputDir) / name.filename() : name;
         }
+    }
 
-        LocalRenamingVisitor localRenaming;
-        localRenaming.visit(*function);
+    // Two files compiled at the same time must not write the same output
+    vector<std::filesystem::path> sortedOutputs = outputs;
+    std::sort(sortedOutputs.begin(), sortedOutputs.end());
+    auto duplicate = std::adjacent_find(sortedOutputs.begin(), sortedOutputs.end());
+    if (options.concurrent && duplicate != sortedOutputs.end()) {
+        cerr << "error: several input files would be written to " << duplicate->string() << endl;
+        exit(1);
+    }
+
+    // With --client the reports are printed by the server with the diagnostics of each file
+    CompileReport report;
+    bool measured = (commandLine.timeReport || commandLine.memReport) && !remote;
+    if (measured && commandLine.memReport) {
+        countAllocations();
+    }
+
+    auto compile = [&](size_t i, const std::string& dotPrefix, ostream& out, ostream& log, CompileReport* report) {
+        if (remote) {
+            return compileRemotely(commandLine, inputs[i], out, log);
+        }
+        return compileFile(inputs[i], dotPrefix, options, out, log, report);
+    };
 
-        if (!silent) {
-            printer.visit(*function);
-            cfg.visit(*function);
+    if (!options.concurrent) {
+        // A single file spreads its functions over the threads
+        options.jobs = commandLine.jobs;
+        // With dumps, the diagnostics are written by the writer too so they stay in order with the IR
+        std::optional<BackgroundLog> backgroundLog;
+        if (dumpWriter) {
+            backgroundLog.emplace(*dumpWriter, cerr);
+        }
+        ostream& log = backgroundLog ? static_cast<ostream&>(*backgroundLog) : cerr;
+        int status;
+        if (outputs[0].empty()) {
+            status = compile(0, "", cout, log, measured ? &report : nullptr);
+        } else {
+            ofstream out(outputs[0]);
+            if (!out) {
+                cerr << "error: cannot write file: " << outputs[0].string() << endl;
+                exit(1);
+            }
+            status = compile(0, "", out, log, measured ? &report : nullptr);
+            out.close();
+            if (status != 0) {
+                std::filesystem::remove(outputs[0]);
+            }
         }
+        // Every dump is written before the reports
+        backgroundLog.reset();
+        options.dumpWriter = nullptr;
+        dumpWriter.reset();
+        if (status != 0) {
+            return status;
+        }
+    } else {
+        // The files are spread over the threads and the functions of each file are compiled in order. Each file
+        // writes its diagnostics and its report in its own buffers, printed in the order of the command line
+        vector<stringstream> logBuffers(inputs.size());
+        vector<CompileReport> fileReports(measured ? inputs.size() : 0);
+        vector<int> statuses(inputs.size());
+        parallelFor(inputs.size(), commandLine.jobs, [&](size_t i) {
+            ofstream out(outputs[i]);
+            if (!out) {
+                logBuffers[i] << "error: cannot write file: " << outputs[i].string() << endl;
+                statuses[i] = 1;
+                return;
+            }
+            // The files of a batch often have functions with the same name
+            std::string dotPrefix = outputs[i].stem().string() + ".";
+            try {
+                statuses[i] = compile(i, dotPrefix, out, logBuffers[i], measured ? &fileReports[i] : nullptr);
+            } catch (const std::exception& error) {
+                // The other files of the batch are still compiled
+                logBuffers[i] << "error: internal compiler error: " << error.what() << endl;
+                statuses[i] = 1;
+            }
+            out.close();
+            // A file which fails to compile leaves no partial assembly behind
+            if (statuses[i] != 0) {
+                std::filesystem::remove(outputs[i]);
+            }
+        });
 
-        gen.visit(*function);
+        for (size_t i = 0; i < inputs.size(); i++) {
+            if (logBuffers[i].view().empty()) {
+                continue;
+            }
+            cerr << inputs[i] << ":" << endl;
+            cerr << logBuffers[i].view();
+        }
+        for (const auto& fileReport : fileReports) {
+            report.merge(fileReport);
+        }
+
+        if (std::any_of(statuses.begin(), statuses.end(), [](int status) { return status != 0; })) {
+            return 1;
+        }
+    }
+
+    if (measured && commandLine.timeReport) {
+        report.printTimes(cerr, commandLine.slowestFunctions);
+    }
+    if (measured && commandLine.memReport) {
+        report.printMemory(cerr);
     }
 
     return 0;
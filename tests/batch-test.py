@@ -0,0 +1,72 @@
+#!/usr/bin/env python3
+
+# This script checks that a batch compilation (`ifcc a.c b.c ... -j N`) gives each file the same result as
+# compiling it alone, even when one of the files makes the compiler fail with an internal error.
+#
+# The test-cases are copied to a temporary directory with a file whose constant does not fit in an int,
+# which makes ifcc throw while generating its IR. Every test-case which compiles alone must get its file.s in
+# the batch, with the same assembly, the failing file must get no file.s, and its diagnostics must be
+# printed under its name.
+
+import argparse
+import os
+import shutil
+import subprocess
+import sys
+import tempfile
+from pathlib import Path
+
+tests_dir = Path(__file__).resolve().parent
+
+argparser = argparse.ArgumentParser(description="Check that a failing file does not stop a batch compilation.")
+argparser.add_argument('--ifcc', default=str(tests_dir.parent / "compiler" / "ifcc"), help='path to ifcc')
+argparser.add_argument('--corpus', default=str(tests_dir / "testfiles"), help='directory of the compiled .c files')
+argparser.add_argument('--jobs', type=int, default=os.cpu_count(), help='number of threads of the batch')
+
+args = argparser.parse_args()
+
+if not Path(args.ifcc).exists():
+    print(f"error: {args.ifcc} does not exist, run `make build` first")
+    sys.exit(1)
+
+ifcc = str(Path(args.ifcc).resolve())
+INTERNAL_ERROR = "error: internal compiler error"
+
+failures = []
+with tempfile.TemporaryDirectory(prefix="ifcc-batch-") as work_dir:
+    corpus = Path(work_dir) / "corpus"
+    shutil.copytree(args.corpus, corpus)
+    bad = corpus / "internal_error.c"
+    bad.write_text("int main() {\n    return 99999999999;\n}\n")
+    sources = sorted(corpus.rglob("*.c"))
+
+    # The assembly of each file compiled alone, None when it does not compile
+    expected = {}
+    for source in sources:
+        result = subprocess.run([ifcc, str(source)], cwd=work_dir, stdout=subprocess.PIPE, stderr=subprocess.DEVNULL)
+        expected[source] = result.stdout if result.returncode == 0 else None
+
+    batch = subprocess.run([ifcc, *map(str, sources), "-j", str(args.jobs)], cwd=work_dir,
+                           stdout=subprocess.DEVNULL, stderr=subprocess.PIPE, text=True, errors="replace")
+    if batch.returncode == 0:
+        failures.append("the batch succeeds although " + bad.name + " fails")
+    if str(bad) + ":\n" + INTERNAL_ERROR not in batch.stderr:
+        failures.append("the internal error of " + bad.name + " is not printed under its name")
+
+    for source in sources:
+        output = source.with_suffix(".s")
+        name = str(source.relative_to(corpus))
+        if expected[source] is None:
+            if output.exists():
+                failures.append(name + ": a file.s is left although it does not compile")
+        elif not output.exists():
+            failures.append(name + ": no file.s although it compiles alone")
+        elif output.read_bytes() != expected[source]:
+            failures.append(name + ": the assembly differs from the one of the file compiled alone")
+
+print(f"{len(sources)} files, {sum(assembly is not None for assembly in expected.values())} compile alone")
+if failures:
+    for failure in failures:
+        print("FAIL " + failure)
+    sys.exit(1)
+print("The batch gives every file the result it has alone")
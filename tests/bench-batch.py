@@ -0,0 +1,59 @@
+#!/usr/bin/env python3
+
+# This script compares the wall time of compiling the whole tests/testfiles corpus with one ifcc
+# process per file and with a single ifcc process compiling every file.
+#
+# The corpus is copied to a temporary directory so each file.s is written next to its file.c. The
+# process per file runs use -o, up to --jobs processes at a time. The batch runs pass every file to
+# one process with -j, which spreads the files over its threads and shares the process startup, the
+# ATN of the grammar, the DFA cache of ANTLR and the type pool between them. Both are measured with
+# one job and with --jobs jobs, the invalid programs of the corpus are compiled too.
+
+import os
+import shutil
+import subprocess
+from concurrent.futures import ThreadPoolExecutor
+from pathlib import Path
+
+from bench_common import argument_parser, check_ifcc, fastest, remove_work_directory, work_directory
+
+argparser = argument_parser("Compare one ifcc process per file with a single batch process.", repeat=3,
+                            corpus=True, O0=True)
+argparser.add_argument('--jobs', type=int, default=os.cpu_count(), help='number of parallel jobs')
+
+args = argparser.parse_args()
+check_ifcc(args.ifcc)
+
+ifcc = str(Path(args.ifcc).resolve())
+flags = ["-s"] + (["-O0"] if args.O0 else [])
+
+work_dir = work_directory()
+corpus = work_dir / "corpus"
+shutil.copytree(args.corpus, corpus)
+sources = sorted(str(path) for path in corpus.rglob("*.c"))
+
+
+def compile_one(source):
+    subprocess.run([ifcc, source, *flags, "-o", source[:-2] + ".s"], cwd=work_dir,
+                   stdout=subprocess.DEVNULL, stderr=subprocess.DEVNULL)
+
+
+def process_per_file(jobs):
+    with ThreadPoolExecutor(jobs) as executor:
+        list(executor.map(compile_one, sources))
+
+
+def batch(jobs):
+    # The invalid programs make ifcc fail, the other files are compiled anyway
+    subprocess.run([ifcc, *sources, *flags, "-j", str(jobs)], cwd=work_dir,
+                   stdout=subprocess.DEVNULL, stderr=subprocess.DEVNULL)
+
+
+print(str(len(sources)) + " files")
+print("{:>6}{:>22}{:>14}{:>10}".format("jobs", "process per file (s)", "batch (s)", "speedup"))
+for jobs in sorted({1, args.jobs}):
+    separate = fastest(args.repeat, process_per_file, jobs)
+    shared = fastest(args.repeat, batch, jobs)
+    print("{:>6}{:>22.3f}{:>14.3f}{:>10.2f}".format(jobs, separate, shared, separate / shared))
+
+remove_work_directory(work_dir)
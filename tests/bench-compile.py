@@ -0,0 +1,139 @@
+#!/usr/bin/env python3
+
+# This script measures how the compile time of ifcc grows with the size of the program.
+#
+# For each dimension (number of functions, locals, blocks, loop depth, string literals and
+# call arguments), it generates programs of increasing size with gen-program.py, compiles them
+# with `ifcc -ftime-report` and fits the time of each phase to size^k with a least squares fit
+# in log-log space. The script fails when k is above the complexity expected for the phase,
+# which catches the quadratic paths the small programs of tests/testfiles never exercise.
+#
+# Phases faster than --min-ms on the largest program are only reported: their time is mostly
+# noise and the fitted exponent means nothing.
+
+import math
+import sys
+
+from bench_common import (argument_parser, best_report, check_ifcc, generate_program, remove_work_directory,
+                          time_report, work_directory)
+
+argparser = argument_parser("Measure the compile time scaling of ifcc on synthetic programs.", repeat=3, scale=True,
+                            keep=True)
+argparser.add_argument('dimensions', metavar='DIMENSION', nargs='*',
+                       help='dimensions to measure (default: all of them)')
+argparser.add_argument('--tolerance', type=float, default=0.3,
+                       help='how much a fitted exponent may exceed its bound before failing')
+argparser.add_argument('--min-ms', type=float, default=5.0,
+                       help='do not check phases faster than this on the largest program')
+argparser.add_argument('-v', '--verbose', action="count", default=0, help='print the time of every run')
+
+args = argparser.parse_args()
+
+# Sizes of each dimension, the options given to gen-program.py for the other dimensions, and the
+# expected complexity of each phase as an exponent of the size ("*" is the default of the dimension)
+DIMENSIONS = {
+    "functions": {
+        "sizes": [25, 50, 100, 200, 400],
+        "base": {},
+        "bounds": {"*": 1.0},
+    },
+    "locals": {
+        "sizes": [16, 32, 64, 128, 256],
+        "base": {"functions": 4},
+        # Every local is alive until the return statement so the interference graph is a clique
+        # and the dataflow analyses work on sets as big as the function
+        "bounds": {"*": 2.0},
+    },
+    "blocks": {
+        "sizes": [50, 100, 200, 400, 800],
+        "base": {"functions": 4},
+        "bounds": {"*": 1.0},
+    },
+    "depth": {
+        "sizes": [2, 4, 8, 16, 32],
+        "base": {"functions": 4},
+        # Iterative dataflow needs one more iteration for each nested loop
+        "bounds": {"*": 1.0, "propagate": 2.0, "dce": 2.0, "two-step": 2.0, "liveness": 2.0},
+    },
+    "literals": {
+        "sizes": [250, 500, 1000, 2000, 4000],
+        # All the literals in the same function
+        "base": {"functions": 1},
+        "bounds": {"*": 1.0},
+    },
+    "args": {
+        "sizes": [4, 8, 16, 32, 64],
+        "base": {"functions": 8, "locals": 2},
+        # Arguments are all alive in the prologue
+        "bounds": {"*": 1.0, "interference graph": 2.0, "register allocation": 2.0},
+    },
+}
+
+for dimension in args.dimensions:
+    if dimension not in DIMENSIONS:
+        print("error: unknown dimension '" + dimension + "', available dimensions are: " + " ".join(DIMENSIONS))
+        sys.exit(1)
+
+check_ifcc(args.ifcc)
+
+
+def fit_exponent(sizes, times):
+    """Slope of the least squares line through (log size, log time)"""
+    xs = [math.log(size) for size in sizes]
+    ys = [math.log(max(time, 1e-3)) for time in times]
+    mean_x = sum(xs) / len(xs)
+    mean_y = sum(ys) / len(ys)
+    covariance = sum((x - mean_x) * (y - mean_y) for x, y in zip(xs, ys))
+    variance = sum((x - mean_x) ** 2 for x in xs)
+    return covariance / variance
+
+
+work_dir = work_directory(args.keep)
+
+failures = []
+for dimension in args.dimensions or DIMENSIONS:
+    config = DIMENSIONS[dimension]
+    sizes = [max(1, round(size * args.scale)) for size in config["sizes"]]
+
+    # times[phase][i] is the time of phase on the program of size sizes[i]
+    times = {}
+    for i, size in enumerate(sizes):
+        options = dict(config["base"])
+        options[dimension] = size
+        source = work_dir / (dimension + "-" + str(size) + ".c")
+        generate_program(source, **options)
+
+        best = best_report(args.repeat, time_report, args.ifcc, source, "-s")
+        if args.verbose:
+            print(dimension + "=" + str(size) + ": " + ", ".join(p + " " + str(t) + "ms" for p, t in best.items()))
+
+        for phase, time in best.items():
+            times.setdefault(phase, [0.0] * len(sizes))[i] = time
+
+    print(dimension + " (" + ", ".join(str(size) for size in sizes) + ")")
+    print("    {:<24}{:>14}{:>10}{:>8}".format("phase", "largest (ms)", "exponent", "bound"))
+    for phase, phase_times in times.items():
+        exponent = fit_exponent(sizes, phase_times)
+        bound = config["bounds"].get(phase, config["bounds"]["*"])
+        if phase == "total":
+            bound = max(config["bounds"].values())
+
+        status = ""
+        if phase_times[-1] < args.min_ms:
+            status = "(too fast to check)"
+        elif exponent > bound + args.tolerance:
+            status = "FAIL"
+            failures.append(dimension + ": " + phase + " grows as size^" + "{:.2f}".format(exponent)
+                            + ", expected at most size^" + str(bound))
+        print("    {:<24}{:>14.3f}{:>10.2f}{:>8.1f}  {}".format(phase, phase_times[-1], exponent, bound, status))
+    print()
+
+remove_work_directory(work_dir, args.keep)
+
+if failures:
+    print("Compile time grows faster than expected:")
+    for failure in failures:
+        print("    " + failure)
+    sys.exit(1)
+
+print("Compile time scales as expected")
@@ -0,0 +1,43 @@
+#!/usr/bin/env python3
+
+# This script measures the throughput of the assembly emission of ifcc, in MB of assembly per second.
+#
+# It generates a large program with gen-program.py and compiles it with `ifcc -O0 -ftime-report -o file.s`.
+# The emission time is the time of the "print asm" phase, which formats the instructions of each function
+# and writes them to the output. The throughput of the whole compilation is reported next to it.
+#
+# With --baseline, the same program is compiled by a second ifcc, for example one built from an older
+# commit, and both are printed.
+
+from bench_common import (argument_parser, best_report, check_ifcc, generate_program, remove_work_directory,
+                          time_report, work_directory)
+
+argparser = argument_parser("Measure the assembly emission throughput of ifcc.", repeat=5, scale=True, keep=True)
+argparser.add_argument('--baseline', metavar='IFCC', help='also measure this ifcc')
+
+args = argparser.parse_args()
+check_ifcc(args.ifcc, args.baseline)
+
+# Options of gen-program.py, about 25 MB of assembly at -O0
+FUNCTIONS = 2000
+PROGRAM_OPTIONS = {"locals": 16, "blocks": 16, "depth": 2, "args": 4, "literals": 100}
+
+work_dir = work_directory(args.keep)
+
+source = work_dir / "emit.c"
+generate_program(source, functions=max(1, round(FUNCTIONS * args.scale)), **PROGRAM_OPTIONS)
+
+print("{:>10}{:>12}{:>14}{:>14}{:>16}{:>16}".format("", "asm (MB)", "emit (ms)", "total (ms)", "emit (MB/s)",
+                                                    "total (MB/s)"))
+for name, ifcc in [("ifcc", args.ifcc), ("baseline", args.baseline)]:
+    if not ifcc:
+        continue
+    output = work_dir / ("emit-" + name + ".s")
+    best = best_report(args.repeat, time_report, ifcc, source, "-O0", "-o", str(output))
+    emit = best["print asm"]
+    total = best["total"]
+    size = output.stat().st_size / 1e6
+    print("{:>10}{:>12.1f}{:>14.1f}{:>14.1f}{:>16.1f}{:>16.1f}".format(name, size, emit, total,
+                                                                       size / emit * 1000, size / total * 1000))
+
+remove_work_directory(work_dir, args.keep)
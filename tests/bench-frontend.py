@@ -0,0 +1,51 @@
+#!/usr/bin/env python3
+
+# This script measures the speedup of the front end enabled by -ffast-frontend, which emits the IR
+# while parsing, over the ANTLR parser followed by IrGenVisitor.
+#
+# It generates programs of increasing size with gen-program.py and compiles each of them with
+# `ifcc -ftime-report`, with and without -ffast-frontend. The time of the front end is the time of
+# the "parsing", "parsing (LL fallback)" and "ir generation" phases for ANTLR and the time of the
+# "parsing + ir generation" phase for -ffast-frontend. Lexing is shared by both and reported apart.
+
+import math
+
+from bench_common import (argument_parser, best_report, check_ifcc, generate_program, remove_work_directory,
+                          time_report, work_directory)
+
+argparser = argument_parser("Compare the front end time of ANTLR and of -ffast-frontend.", repeat=5, scale=True,
+                            keep=True)
+
+args = argparser.parse_args()
+check_ifcc(args.ifcc)
+
+# Number of functions of each generated program, the other options of gen-program.py are fixed
+SIZES = [25, 100, 400]
+PROGRAM_OPTIONS = {"locals": 16, "blocks": 16, "depth": 2, "args": 4}
+
+ANTLR_PHASES = ["parsing", "parsing (LL fallback)", "ir generation"]
+FAST_PHASES = ["parsing + ir generation"]
+
+
+def best_times(source, *flags):
+    """Fastest time of each phase over --repeat runs"""
+    return best_report(args.repeat, time_report, args.ifcc, source, "-s", "-O0", *flags)
+
+
+work_dir = work_directory(args.keep)
+
+print("{:>10}{:>14}{:>16}{:>16}{:>10}".format("functions", "lexing (ms)", "ANTLR (ms)", "fast (ms)", "speedup"))
+for size in SIZES:
+    size = max(1, round(size * args.scale))
+    source = work_dir / ("frontend-" + str(size) + ".c")
+    generate_program(source, functions=size, **PROGRAM_OPTIONS)
+
+    antlr = best_times(source)
+    fast = best_times(source, "-ffast-frontend")
+    antlr_time = sum(antlr.get(phase, 0.0) for phase in ANTLR_PHASES)
+    fast_time = sum(fast.get(phase, 0.0) for phase in FAST_PHASES)
+    speedup = antlr_time / fast_time if fast_time > 0 else math.inf
+    print("{:>10}{:>14.3f}{:>16.3f}{:>16.3f}{:>9.1f}x".format(size, antlr.get("lexing", 0.0), antlr_time,
+                                                              fast_time, speedup))
+
+remove_work_directory(work_dir, args.keep)
@@ -0,0 +1,57 @@
+#!/usr/bin/env python3
+
+# This script measures the heap allocations of the IR generation per node of the parse tree, on
+# programs made of deeply nested expressions.
+#
+# Every statement of the generated programs assigns an expression nested --depth times:
+#
+#     r = ((((a + 1) * a) - 2) ^ a);
+#
+# Each level of nesting adds three expression nodes to the parse tree: the parentheses, the binary
+# operator and its right operand. The programs are compiled with `ifcc -fmem-report` and the
+# allocations of the "ir generation" phase are divided by the number of expression nodes. The
+# same programs are compiled with -ffast-frontend, which has no parse tree, for comparison.
+
+from bench_common import argument_parser, check_ifcc, memory_report, remove_work_directory, work_directory
+
+argparser = argument_parser("Measure the allocations per parse tree node of the IR generation.", keep=True)
+argparser.add_argument('--depths', type=int, nargs='+', default=[16, 64, 256], help='nesting depths to measure')
+argparser.add_argument('--statements', type=int, default=200, help='number of nested expressions in each program')
+
+args = argparser.parse_args()
+check_ifcc(args.ifcc)
+
+OPERATORS = ["+", "*", "-", "^", "|", "&"]
+
+
+def nested_expression(depth, seed):
+    expression = "a"
+    for level in range(depth):
+        operand = "a" if (level + seed) % 2 else str(level % 7 + 1)
+        expression = "(" + expression + " " + OPERATORS[(level + seed) % len(OPERATORS)] + " " + operand + ")"
+    return expression
+
+
+def generate(path, depth):
+    with open(path, "w") as file:
+        file.write("int main() {\n    int a = 1;\n    int r = 0;\n")
+        for i in range(args.statements):
+            file.write("    r = " + nested_expression(depth, i) + ";\n")
+        file.write("    return r;\n}\n")
+
+
+work_dir = work_directory(args.keep)
+
+print("{:>8}{:>12}{:>16}{:>12}{:>18}{:>12}".format("depth", "nodes", "ir generation", "per node",
+                                                  "-ffast-frontend", "per node"))
+for depth in args.depths:
+    source = work_dir / ("nested-" + str(depth) + ".c")
+    generate(source, depth)
+    # The innermost operand and three nodes by level
+    nodes = args.statements * (3 * depth + 1)
+
+    antlr = memory_report(args.ifcc, source, "-s", "-O0").get("ir generation", 0)
+    fast = memory_report(args.ifcc, source, "-s", "-O0", "-ffast-frontend").get("parsing + ir generation", 0)
+    print("{:>8}{:>12}{:>16}{:>12.2f}{:>18}{:>12.2f}".format(depth, nodes, antlr, antlr / nodes, fast, fast / nodes))
+
+remove_work_directory(work_dir, args.keep)
@@ -0,0 +1,155 @@
+#!/usr/bin/env python3
+
+# This script measures how fast the code generated by ifcc runs.
+#
+# Each kernel of tests/benchmarks is built with ifcc -O0, ifcc, gcc -O0 and gcc -O2, then run
+# several times. The script checks that the four executables print the same thing and return the
+# same code, and reports the median runtime, the standard deviation and the speedup ratios of
+# each build as a table, and optionally as JSON to track them over time.
+
+import json
+import os
+import statistics
+import subprocess
+import sys
+import tempfile
+import time
+from datetime import datetime, timezone
+from pathlib import Path
+
+from bench_common import argument_parser, check_ifcc, tests_dir
+
+argparser = argument_parser("Compare the runtime of programs compiled by ifcc and GCC.")
+argparser.add_argument('input', metavar='PATH', nargs='*', default=[str(tests_dir / "benchmarks")],
+                       help='kernels to run, or directories containing them (default: tests/benchmarks)')
+argparser.add_argument('--runs', type=int, default=5, help='number of runs of each executable')
+argparser.add_argument('--json', metavar='FILE', help='also write the results to FILE as JSON')
+
+args = argparser.parse_args()
+
+kernels = []
+for path_str in args.input:
+    path = Path(path_str)
+    if path.is_dir():
+        kernels += sorted(path.glob("*.c"))
+    elif path.suffix == ".c":
+        kernels.append(path)
+    else:
+        print(f"error: cannot read input path: {path}")
+        sys.exit(1)
+
+if not kernels:
+    print("error: found no kernel in: ", " ".join(args.input))
+    sys.exit(1)
+
+check_ifcc(args.ifcc)
+
+# Name of each build and how to turn a kernel into assembly
+BUILDS = {
+    "ifcc -O0": lambda source, asm: [args.ifcc, source, "-O0", "-s"],
+    "ifcc": lambda source, asm: [args.ifcc, source, "-s"],
+    "gcc -O0": lambda source, asm: ["gcc", "-O0", "-S", "-w", "-o", asm, source],
+    "gcc -O2": lambda source, asm: ["gcc", "-O2", "-S", "-w", "-o", asm, source],
+}
+
+
+def build(name, source, work_dir):
+    """Compile source with the given build, return the path of the executable"""
+    stem = source.stem + "-" + name.replace(" ", "").replace("-", "")
+    asm = work_dir / (stem + ".s")
+    exe = work_dir / stem
+
+    command = BUILDS[name](str(source.resolve()), str(asm))
+    # ifcc writes the assembly on stdout and the CFG of each function in the current directory
+    output = None if name.startswith("gcc") else asm.open("w")
+    compilation = subprocess.run(command, cwd=work_dir, stdout=output, stderr=subprocess.PIPE, text=True)
+    if output:
+        output.close()
+    if compilation.returncode != 0:
+        print(compilation.stderr)
+        print(f"error: {name} failed to compile {source}")
+        sys.exit(1)
+
+    link = subprocess.run(["gcc", "-o", exe, asm], stderr=subprocess.PIPE, text=True)
+    if link.returncode != 0:
+        print(link.stderr)
+        print(f"error: cannot link the assembly produced by {name} for {source}")
+        sys.exit(1)
+
+    return exe
+
+
+def run(exe):
+    """Run exe once, return its runtime in seconds and its output"""
+    start = time.perf_counter()
+    execution = subprocess.run([exe], stdout=subprocess.PIPE)
+    elapsed = time.perf_counter() - start
+    return elapsed, (execution.returncode, execution.stdout)
+
+
+results = {}
+mismatches = []
+with tempfile.TemporaryDirectory(prefix="ifcc-runtime-") as work_dir:
+    for source in kernels:
+        print(f"{source.stem}: ", end="", flush=True)
+        kernel_results = {}
+        reference = None
+        for name in BUILDS:
+            exe = build(name, source, Path(work_dir))
+            times = []
+            for _ in range(args.runs):
+                elapsed, output = run(exe)
+                times.append(elapsed)
+                if reference is None:
+                    reference = output
+                elif output != reference:
+                    mismatches.append(f"{source.stem}: {name} does not behave like ifcc -O0")
+            print(".", end="", flush=True)
+
+            kernel_results[name] = {
+                "median": statistics.median(times),
+                "stdev": statistics.stdev(times) if len(times) > 1 else 0.0,
+                "times": times,
+            }
+        print()
+        results[source.stem] = kernel_results
+
+# Speedups are relative to the unoptimized output of ifcc, and to gcc -O2 to see how far we are
+print()
+print("{:<16}{:<12}{:>12}{:>12}{:>14}{:>14}".format(
+    "kernel", "build", "median (s)", "stdev (s)", "vs ifcc -O0", "vs gcc -O2"))
+for kernel, kernel_results in results.items():
+    for name, result in kernel_results.items():
+        result["speedup_vs_ifcc_O0"] = kernel_results["ifcc -O0"]["median"] / result["median"]
+        result["speedup_vs_gcc_O2"] = kernel_results["gcc -O2"]["median"] / result["median"]
+        print("{:<16}{:<12}{:>12.4f}{:>12.4f}{:>13.2f}x{:>13.2f}x".format(
+            kernel, name, result["median"], result["stdev"],
+            result["speedup_vs_ifcc_O0"], result["speedup_vs_gcc_O2"]))
+
+print()
+print("Geometric mean of the speedups over all kernels")
+for name in BUILDS:
+    speedups = [kernel_results[name]["speedup_vs_ifcc_O0"] for kernel_results in results.values()]
+    relative = [kernel_results[name]["speedup_vs_gcc_O2"] for kernel_results in results.values()]
+    print("{:<28}{:>12.2f}x{:>13.2f}x".format(
+        name, statistics.geometric_mean(speedups), statistics.geometric_mean(relative)))
+
+if args.json:
+    commit = subprocess.run(["git", "rev-parse", "HEAD"], cwd=tests_dir, stdout=subprocess.PIPE,
+                            stderr=subprocess.DEVNULL, text=True).stdout.strip()
+    report = {
+        "date": datetime.now(timezone.utc).isoformat(),
+        "commit": commit or None,
+        "host": os.uname().nodename,
+        "runs": args.runs,
+        "kernels": results,
+    }
+    with open(args.json, "w") as file:
+        json.dump(report, file, indent=2)
+    print(f"\nResults written to {args.json}")
+
+if mismatches:
+    print()
+    for mismatch in mismatches:
+        print("error: " + mismatch)
+    sys.exit(1)
@@ -0,0 +1,99 @@
+#!/usr/bin/env python3
+
+# This script compares the latency of compiling each file of tests/testfiles with a new ifcc process
+# and with a request to a warm `ifcc --server`.
+#
+# A server is started on a socket in a temporary directory and every file is compiled once first, so
+# the DFA cache of the parser is warm. Then each file is compiled:
+#
+# - cold:    by a new `ifcc file.c` process, which builds the ATN and warms the DFA cache again
+# - client:  by `ifcc --client`, a new process which sends the file to the server
+# - request: by sending the request to the server from this script, without starting any process
+#
+# The request column is the latency an editor keeping its own connection code would see.
+
+import os
+import socket
+import statistics
+import struct
+import subprocess
+import sys
+import time
+from pathlib import Path
+
+from bench_common import argument_parser, check_ifcc, fastest, remove_work_directory, work_directory
+
+argparser = argument_parser("Compare the latency of a cold ifcc process and of ifcc --server.", repeat=3,
+                            corpus=True, O0=True)
+
+args = argparser.parse_args()
+check_ifcc(args.ifcc)
+
+ifcc = str(Path(args.ifcc).resolve())
+flags = ["-s"] + (["-O0"] if args.O0 else [])
+sources = sorted(Path(args.corpus).rglob("*.c"))
+
+work_dir = work_directory()
+socket_path = str(work_dir / "ifcc.sock")
+
+
+def encode_string(data):
+    return struct.pack("=Q", len(data)) + data
+
+
+def receive(connection, size):
+    data = b""
+    while len(data) < size:
+        chunk = connection.recv(size - len(data))
+        if not chunk:
+            print("error: the server closed the connection")
+            sys.exit(1)
+        data += chunk
+    return data
+
+
+def request(source):
+    """Send source to the server like ifcc --client and return the exit status"""
+    message = struct.pack("=I", len(flags)) + b"".join(encode_string(flag.encode()) for flag in flags)
+    message += encode_string(str(source).encode()) + encode_string(source.read_bytes())
+    with socket.socket(socket.AF_UNIX, socket.SOCK_STREAM) as connection:
+        connection.connect(socket_path)
+        connection.sendall(message)
+        (status,) = struct.unpack("=i", receive(connection, 4))
+        for _ in range(2):
+            (size,) = struct.unpack("=Q", receive(connection, 8))
+            receive(connection, size)
+    return status
+
+
+def run(command):
+    subprocess.run(command, cwd=work_dir, stdout=subprocess.DEVNULL, stderr=subprocess.DEVNULL)
+
+
+server = subprocess.Popen([ifcc, "--server", socket_path], cwd=work_dir)
+try:
+    while not os.path.exists(socket_path):
+        if server.poll() is not None:
+            print("error: the server did not start")
+            sys.exit(1)
+        time.sleep(0.01)
+
+    # Warm the DFA cache of the server with every file
+    for source in sources:
+        request(source)
+
+    times = {"cold": [], "client": [], "request": []}
+    for source in sources:
+        times["cold"].append(fastest(args.repeat, run, [ifcc, str(source), *flags]) * 1000)
+        times["client"].append(fastest(args.repeat, run, [ifcc, "--client", socket_path, str(source), *flags]) * 1000)
+        times["request"].append(fastest(args.repeat, request, source) * 1000)
+finally:
+    server.terminate()
+    server.wait()
+    remove_work_directory(work_dir)
+
+print(str(len(sources)) + " files, latency in ms")
+print("{:>10}{:>12}{:>12}{:>12}".format("", "median", "mean", "total"))
+for name, values in times.items():
+    print("{:>10}{:>12.2f}{:>12.2f}{:>12.1f}".format(name, statistics.median(values), statistics.mean(values),
+                                                     sum(values)))
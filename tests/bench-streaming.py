@@ -0,0 +1,57 @@
+#!/usr/bin/env python3
+
+# This script measures the peak RSS of ifcc on large generated programs, with the whole program in
+# memory and with -fstreaming, which compiles each function as soon as it is parsed.
+#
+# It generates programs of increasing size with gen-program.py and compiles each of them with the
+# ANTLR parser, with -ffast-frontend and with -fstreaming. The peak RSS of each run is read from
+# the resource usage of the ifcc process.
+
+import os
+import subprocess
+import sys
+import time
+
+from bench_common import argument_parser, check_ifcc, generate_program, remove_work_directory, work_directory
+
+argparser = argument_parser("Compare the peak RSS of ifcc with and without -fstreaming.", scale=True, keep=True)
+
+args = argparser.parse_args()
+check_ifcc(args.ifcc)
+
+# Number of functions of each generated program, the other options of gen-program.py are fixed
+SIZES = [250, 1000, 4000]
+PROGRAM_OPTIONS = {"locals": 16, "blocks": 16, "depth": 2, "args": 4}
+
+MODES = [("ANTLR", []), ("-ffast-frontend", ["-ffast-frontend"]), ("-fstreaming", ["-fstreaming"])]
+
+
+def peak_rss(source, *flags):
+    """Run ifcc on source and return its peak RSS in MB and its wall time in s"""
+    start = time.perf_counter()
+    process = subprocess.Popen([args.ifcc, str(source), "-s", "-O0", *flags],
+                               stdout=subprocess.DEVNULL, stderr=subprocess.DEVNULL)
+    _, status, usage = os.wait4(process.pid, 0)
+    process.returncode = os.waitstatus_to_exitcode(status)
+    if process.returncode != 0:
+        print("error: ifcc failed on " + str(source))
+        sys.exit(1)
+    # ru_maxrss is in kB on Linux
+    return usage.ru_maxrss / 1024, time.perf_counter() - start
+
+
+work_dir = work_directory(args.keep)
+
+print("{:>10}{:>12}".format("functions", "size (MB)") + "".join("{:>20}".format(name) for name, _ in MODES))
+for size in SIZES:
+    size = max(1, round(size * args.scale))
+    source = work_dir / ("streaming-" + str(size) + ".c")
+    generate_program(source, functions=size, **PROGRAM_OPTIONS)
+
+    line = "{:>10}{:>12.1f}".format(size, source.stat().st_size / 2**20)
+    for _, flags in MODES:
+        rss, wall = peak_rss(source, *flags)
+        line += "{:>20}".format("{:.1f} MB ({:.1f} s)".format(rss, wall))
+    print(line)
+
+remove_work_directory(work_dir, args.keep)
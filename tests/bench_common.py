@@ -0,0 +1,132 @@
+# Helpers shared by the bench-*.py scripts: their common command line options, the check that ifcc is
+# built, the generation of the programs with gen-program.py, the reports of `ifcc -ftime-report` and
+# `ifcc -fmem-report`, and the timing of repeated runs.
+
+import argparse
+import math
+import re
+import shutil
+import subprocess
+import sys
+import tempfile
+import time
+from pathlib import Path
+
+tests_dir = Path(__file__).resolve().parent
+
+# "phase  count  wall (ms)  %  cpu (ms)" lines of -ftime-report
+TIME_LINE = re.compile(r"^(\S.*?)\s+(\d+)\s+([\d.]+)\s+([\d.]+)\s+([\d.]+)$")
+# "phase  allocations  bytes allocated  peak RSS" lines of -fmem-report
+MEMORY_LINE = re.compile(r"^(\S.*?)\s+(\d+)\s+(\d+)\s+(\d+)$")
+
+
+def argument_parser(description, repeat=None, scale=False, keep=False, corpus=False, O0=False):
+    """Parser with --ifcc, and the other common options the script asks for. repeat is the default of --repeat"""
+    argparser = argparse.ArgumentParser(description=description)
+    argparser.add_argument('--ifcc', default=str(tests_dir.parent / "compiler" / "ifcc"), help='path to ifcc')
+    if corpus:
+        argparser.add_argument('--corpus', default=str(tests_dir / "testfiles"),
+                               help='directory of the compiled .c files')
+    if repeat:
+        argparser.add_argument('--repeat', type=int, default=repeat, help='keep the fastest of N runs')
+    if scale:
+        argparser.add_argument('--scale', type=float, default=1.0,
+                               help='multiply the size of the generated programs by this factor')
+    if keep:
+        argparser.add_argument('--keep', metavar='DIR', help='keep the generated programs in this directory')
+    if O0:
+        argparser.add_argument('-O0', action='store_true', help='compile without optimizations')
+    return argparser
+
+
+def check_ifcc(*paths):
+    """Exit if one of the ifcc is not built, None paths are ignored"""
+    for path in paths:
+        if path and not Path(path).exists():
+            print("error: " + path + " does not exist, run `make build` first")
+            sys.exit(1)
+
+
+def work_directory(keep=None):
+    """The directory of the generated programs: keep when it is given, a new temporary directory otherwise"""
+    work_dir = Path(keep) if keep else Path(tempfile.mkdtemp(prefix="ifcc-bench-"))
+    work_dir.mkdir(parents=True, exist_ok=True)
+    return work_dir
+
+
+def remove_work_directory(work_dir, keep=None):
+    """Remove the directory of work_directory, unless it was given by --keep"""
+    if not keep:
+        shutil.rmtree(work_dir)
+
+
+def generate_program(path, **options):
+    """Write a program generated by gen-program.py to path, options are the options of gen-program.py"""
+    command = [sys.executable, str(tests_dir / "gen-program.py"), "-o", str(path)]
+    for name, value in options.items():
+        command += ["--" + name, str(value)]
+    subprocess.run(command, check=True)
+
+
+def run_report(ifcc, source, flags):
+    """Run ifcc on source and return its stderr, exit if it fails"""
+    result = subprocess.run([ifcc, str(source), *flags], stdout=subprocess.DEVNULL, stderr=subprocess.PIPE,
+                            text=True)
+    if result.returncode != 0:
+        print(result.stderr)
+        print("error: " + ifcc + " failed on " + str(source))
+        sys.exit(1)
+    return result.stderr
+
+
+def time_report(ifcc, source, *flags):
+    """Run `ifcc source -ftime-report=0 flags` and return the wall time in ms of each phase, and of the "total" """
+    phases = {}
+    in_report = False
+    for line in run_report(ifcc, source, ["-ftime-report=0", *flags]).splitlines():
+        if line.startswith("Time report"):
+            in_report = True
+        elif in_report:
+            match = TIME_LINE.match(line)
+            if match:
+                phases[match.group(1)] = float(match.group(3))
+            elif line.startswith("total"):
+                phases["total"] = float(line.split()[1])
+                break
+    if not phases:
+        print("error: no time report in the output of " + ifcc)
+        sys.exit(1)
+    return phases
+
+
+def memory_report(ifcc, source, *flags):
+    """Run `ifcc source -fmem-report flags` and return the number of allocations of each phase"""
+    phases = {}
+    in_report = False
+    for line in run_report(ifcc, source, ["-fmem-report", *flags]).splitlines():
+        if line.startswith("Memory report"):
+            in_report = True
+        elif in_report:
+            match = MEMORY_LINE.match(line)
+            if match:
+                phases[match.group(1)] = int(match.group(2))
+    return phases
+
+
+def best_report(repeat, report, *report_args):
+    """Lowest value of each phase over repeat calls of report(*report_args)"""
+    best = {}
+    for _ in range(repeat):
+        for phase, value in report(*report_args).items():
+            best[phase] = min(best.get(phase, math.inf), value)
+    return best
+
+
+def fastest(repeat, function, *function_args):
+    """Wall time in s of the fastest of repeat calls of function(*function_args)"""
+    best = math.inf
+    for _ in range(repeat):
+        start = time.perf_counter()
+        function(*function_args)
+        best = min(best, time.perf_counter() - start)
+    return best
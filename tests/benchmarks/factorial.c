@@ -0,0 +1,25 @@
+#include <stdio.h>
+
+// Compute n! modulo a prime recursively for every n below 1000, 300 times
+int fact(int n) {
+    if (n <= 1) {
+        return 1;
+    }
+    return n * fact(n - 1) % 1000003;
+}
+
+int main() {
+    int sum = 0;
+    int round = 0;
+    while (round < 300) {
+        int n = 1;
+        while (n < 1000) {
+            sum = (sum + fact(n)) % 1000003;
+            n++;
+        }
+        round++;
+    }
+
+    printf("%d\n", sum);
+    return 0;
+}
@@ -0,0 +1,14 @@
+#include <stdio.h>
+
+// Naive recursive Fibonacci, about 330 million calls
+int fib(int n) {
+    if (n < 2) {
+        return n;
+    }
+    return fib(n - 1) + fib(n - 2);
+}
+
+int main() {
+    printf("%d\n", fib(40));
+    return 0;
+}
@@ -0,0 +1,28 @@
+#include <stdio.h>
+
+// Sum the gcd of every pair of numbers below 6000
+int gcd(int a, int b) {
+    while (b != 0) {
+        int r = a % b;
+        a = b;
+        b = r;
+    }
+    return a;
+}
+
+int main() {
+    int n = 6000;
+    int sum = 0;
+    int i = 1;
+    while (i < n) {
+        int j = 1;
+        while (j < n) {
+            sum = (sum + gcd(i, j)) % 1000000007;
+            j++;
+        }
+        i++;
+    }
+
+    printf("%d\n", sum);
+    return 0;
+}
@@ -0,0 +1,54 @@
+#include <stdio.h>
+#include <stdlib.h>
+
+// Multiply two 500x500 int matrices, 3 times
+void multiply(int* a, int* b, int* c, int n) {
+    int i = 0;
+    while (i < n) {
+        int j = 0;
+        while (j < n) {
+            int sum = 0;
+            int k = 0;
+            while (k < n) {
+                sum += a[i * n + k] * b[k * n + j];
+                k++;
+            }
+            c[i * n + j] = sum;
+            j++;
+        }
+        i++;
+    }
+}
+
+int main() {
+    int n = 500;
+    int* a = malloc(n * n * 4);
+    int* b = malloc(n * n * 4);
+    int* c = malloc(n * n * 4);
+
+    int i = 0;
+    while (i < n * n) {
+        a[i] = i % 7;
+        b[i] = i % 5;
+        i++;
+    }
+
+    int round = 0;
+    while (round < 3) {
+        multiply(a, b, c, n);
+        round++;
+    }
+
+    int checksum = 0;
+    i = 0;
+    while (i < n * n) {
+        checksum = (checksum + c[i]) % 1000000007;
+        i++;
+    }
+
+    printf("%d\n", checksum);
+    free(a);
+    free(b);
+    free(c);
+    return 0;
+}
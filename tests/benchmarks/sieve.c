@@ -0,0 +1,44 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+
+// Count the primes below 5 000 000 with the sieve of Eratosthenes, 20 times
+int sieve(bool* prime, int size) {
+    int i = 2;
+    while (i < size) {
+        prime[i] = 1;
+        i++;
+    }
+
+    int count = 0;
+    i = 2;
+    while (i < size) {
+        if (prime[i]) {
+            count++;
+            int j = i + i;
+            while (j < size) {
+                prime[j] = 0;
+                j += i;
+            }
+        }
+        i++;
+    }
+
+    return count;
+}
+
+int main() {
+    int size = 5000000;
+    bool* prime = malloc(size);
+
+    int count = 0;
+    int round = 0;
+    while (round < 20) {
+        count = sieve(prime, size);
+        round++;
+    }
+
+    printf("%d\n", count);
+    free(prime);
+    return 0;
+}
@@ -0,0 +1,41 @@
+#include <stdio.h>
+#include <stdlib.h>
+
+// Copy a 1 MB string character by character, 600 times
+int copy(char* destination, char* source) {
+    int i = 0;
+    while (source[i] != '\0') {
+        destination[i] = source[i];
+        i++;
+    }
+    destination[i] = '\0';
+    return i;
+}
+
+int main() {
+    int size = 1000000;
+    char* alphabet = "abcdefghijklmnopqrstuvwxyz";
+    char* source = malloc(size + 1);
+    char* destination = malloc(size + 1);
+
+    int i = 0;
+    while (i < size) {
+        source[i] = alphabet[i % 26];
+        i++;
+    }
+    source[size] = '\0';
+
+    int checksum = 0;
+    int round = 0;
+    while (round < 600) {
+        source[round] = 'A';
+        int length = copy(destination, source);
+        checksum = (checksum + length + destination[round * 7]) % 1000000007;
+        round++;
+    }
+
+    printf("%d\n", checksum);
+    free(source);
+    free(destination);
+    return 0;
+}
@@ -0,0 +1,81 @@
+#!/usr/bin/env python3
+
+# This script checks that the front end enabled by -ffast-frontend, which emits the IR while parsing,
+# generates the same IR as the ANTLR parser followed by IrGenVisitor.
+#
+# Each test-case is compiled twice with `ifcc FILE -O0 -dump-ir`, with and without -ffast-frontend. The
+# IR dumped on stderr, the assembly printed on stdout and the return codes must be identical. When
+# ANTLR reports a syntax error, only the return code and the last line of stderr are compared since
+# the two parsers do not describe the error the same way.
+
+import argparse
+import difflib
+import os
+import subprocess
+import sys
+import tempfile
+from pathlib import Path
+
+tests_dir = Path(__file__).resolve().parent
+
+SYNTAX_ERROR = "error: syntax error during parsing"
+
+argparser = argparse.ArgumentParser(description="Compare the IR generated by the ANTLR parser and by -ffast-frontend.")
+argparser.add_argument('input', metavar='PATH', nargs='*', default=[str(tests_dir / "testfiles")],
+                       help='test-cases, or directories containing them (default: tests/testfiles)')
+argparser.add_argument('--ifcc', default=str(tests_dir.parent / "compiler" / "ifcc"), help='path to ifcc')
+argparser.add_argument('-v', '--verbose', action="count", default=0,
+                       help='print the name of each test-case')
+
+args = argparser.parse_args()
+
+input_files = []
+for path_str in args.input:
+    path = Path(path_str)
+    if path.is_file() and path.suffix == '.c':
+        input_files.append(path.resolve())
+    elif path.is_dir():
+        for dirpath, _, filenames in os.walk(path):
+            input_files += [(Path(dirpath) / filename).resolve() for filename in filenames if filename.endswith('.c')]
+    else:
+        print(f"error: cannot read input path: {path}")
+        sys.exit(1)
+
+if not Path(args.ifcc).exists():
+    print(f"error: {args.ifcc} does not exist, run `make build` first")
+    sys.exit(1)
+
+
+def compile(source, work_dir, *flags):
+    result = subprocess.run([args.ifcc, str(source), "-O0", "-dump-ir", *flags], cwd=work_dir,
+                            stdout=subprocess.PIPE, stderr=subprocess.PIPE, text=True, errors="replace")
+    if result.returncode != 0 and result.stderr.rstrip().endswith(SYNTAX_ERROR):
+        return result.returncode, "", SYNTAX_ERROR
+    return result.returncode, result.stdout, result.stderr
+
+
+failures = []
+with tempfile.TemporaryDirectory(prefix="ifcc-frontend-") as work_dir:
+    for source in sorted(input_files):
+        expected = compile(source, work_dir)
+        actual = compile(source, work_dir, "-ffast-frontend")
+        if args.verbose:
+            print(("OK   " if actual == expected else "FAIL ") + str(source))
+        else:
+            print("." if actual == expected else "F", end="", flush=True)
+        if actual != expected:
+            failures.append((source, expected, actual))
+
+if not args.verbose:
+    print()
+
+for source, expected, actual in failures:
+    print(f"\nFAIL {source}")
+    if actual[0] != expected[0]:
+        print(f"return code: ANTLR {expected[0]}, -ffast-frontend {actual[0]}")
+    for name, old, new in (("stdout", expected[1], actual[1]), ("stderr", expected[2], actual[2])):
+        sys.stdout.writelines(difflib.unified_diff(old.splitlines(keepends=True), new.splitlines(keepends=True),
+                                                   f"ANTLR {name}", f"-ffast-frontend {name}"))
+
+print(f"\n{len(input_files) - len(failures)}/{len(input_files)} test-cases compiled identically")
+sys.exit(1 if failures else 0)
@@ -0,0 +1,113 @@
+#!/usr/bin/env python3
+
+# This script generates a large program in the language accepted by ifcc (see compiler/ifcc.g4).
+#
+# It is used by bench-compile.py to measure how the compile time of ifcc grows with the size of
+# the program, but the generated program is also a valid C program which can be compiled with GCC.
+#
+# Every function of the generated program looks like this:
+#
+#     int f3(int a0, int a1) {
+#         int v0 = a0 + 1, v1 = v0 * 3 + a1, ...;      <- --locals
+#         char* s0 = "literal 0";                     <- --literals (spread over the functions)
+#         int i0 = 0, i1 = 0;
+#         while (i0 < 2) {                            <- --depth nested loops
+#             i1 = 0;
+#             while (i1 < 2) { v0 = v0 + v1; i1 = i1 + 1; }
+#             i0 = i0 + 1;
+#         }
+#         if (v1 > 4) { v0 = v0 - v1; } else { ... }  <- --blocks if/else statements
+#         v0 = v0 + f2(v1, v0);                       <- --args call arguments
+#         return v0 + v1 + ... + s0[1];
+#     }
+#
+# Every local stays alive until the return statement so the register allocator has to deal
+# with all of them at once.
+
+import argparse
+import random
+import sys
+
+argparser = argparse.ArgumentParser(description="Generate a synthetic program for ifcc.")
+argparser.add_argument('--functions', type=int, default=10, help='number of functions')
+argparser.add_argument('--locals', type=int, default=8, help='number of int locals in each function')
+argparser.add_argument('--blocks', type=int, default=8, help='number of if/else statements in each function')
+argparser.add_argument('--depth', type=int, default=1, help='loop nesting depth in each function')
+argparser.add_argument('--literals', type=int, default=0, help='number of string literals in the whole program')
+argparser.add_argument('--args', type=int, default=2, help='number of arguments of each function')
+argparser.add_argument('--seed', type=int, default=0, help='seed of the random generator')
+argparser.add_argument('-o', '--output', help='write the program to this file instead of stdout')
+
+args = argparser.parse_args()
+rng = random.Random(args.seed)
+
+
+def local(count):
+    return "v" + str(rng.randrange(count))
+
+
+def generate_function(index, literals):
+    lines = []
+    params = ", ".join("int a" + str(i) for i in range(args.args))
+    lines.append("int f" + str(index) + "(" + params + ") {")
+
+    # Each local depends on the previous ones and on the arguments
+    local_count = max(args.locals, 1)
+    initializers = []
+    for i in range(local_count):
+        value = "a" + str(i % args.args) if args.args > 0 else str(i)
+        if i > 0:
+            value = "v" + str(rng.randrange(i)) + " * " + str(rng.randrange(1, 5)) + " + " + value
+        initializers.append("v" + str(i) + " = " + value)
+    lines.append("    int " + ", ".join(initializers) + ";")
+
+    for i, literal in enumerate(literals):
+        lines.append("    char* s" + str(i) + " = \"literal " + str(literal) + "\";")
+
+    if args.depth > 0:
+        lines.append("    int " + ", ".join("i" + str(d) + " = 0" for d in range(args.depth)) + ";")
+        indent = "    "
+        for d in range(args.depth):
+            if d > 0:
+                lines.append(indent + "i" + str(d) + " = 0;")
+            lines.append(indent + "while (i" + str(d) + " < 2) {")
+            indent += "    "
+        lines.append(indent + local(local_count) + " = " + local(local_count) + " + " + local(local_count) + ";")
+        for d in reversed(range(args.depth)):
+            lines.append(indent + "i" + str(d) + " = i" + str(d) + " + 1;")
+            indent = indent[4:]
+            lines.append(indent + "}")
+
+    for _ in range(args.blocks):
+        lines.append("    if (" + local(local_count) + " > " + str(rng.randrange(10)) + ") {")
+        lines.append("        " + local(local_count) + " = " + local(local_count) + " - " + local(local_count) + ";")
+        lines.append("    } else {")
+        lines.append("        " + local(local_count) + " = " + local(local_count) + " + " + str(rng.randrange(10)) + ";")
+        lines.append("    }")
+
+    # Only call functions defined before so there is no need for declarations
+    if index > 0:
+        call_args = ", ".join(local(local_count) for _ in range(args.args))
+        lines.append("    v0 = v0 + f" + str(index - 1) + "(" + call_args + ");")
+
+    result = " + ".join("v" + str(i) for i in range(local_count))
+    for i in range(len(literals)):
+        result += " + s" + str(i) + "[" + str(i % 8) + "]"
+    lines.append("    return " + result + ";")
+    lines.append("}")
+    return "\n".join(lines)
+
+
+functions = max(args.functions, 1)
+program = []
+for index in range(functions):
+    # Spread the literals as evenly as possible over the functions
+    first = args.literals * index // functions
+    last = args.literals * (index + 1) // functions
+    program.append(generate_function(index, range(first, last)))
+
+call_args = ", ".join(str(i) for i in range(args.args))
+program.append("int main() {\n    return f" + str(functions - 1) + "(" + call_args + ") % 256;\n}")
+
+output = open(args.output, "w") if args.output else sys.stdout
+output.write("\n\n".join(program) + "\n")
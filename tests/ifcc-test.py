@@ -38,6 +38,10 @@ argparser.add_argument('-d', '--debug', action="count", default=0,
                        help='Increase quantity of debugging messages (only useful to debug the test script itself)')
 argparser.add_argument('-v', '--verbose', action="count", default=0,
                        help='Increase verbosity level. You can use this option multiple times.')
+argparser.add_argument('-c', '--object', action="store_true",
+                       help='Compile with ifcc -c and link the object instead of assembling the output of ifcc')
+argparser.add_argument('--streaming', action="store_true",
+                       help='Compile with ifcc -fstreaming, which generates each function as soon as it is parsed')
 
 args = argparser.parse_args()
 
@@ -115,10 +119,12 @@ async def job(input_file: Path, semaphore: asyncio.Semaphore):
             p / "input.c",
             stderr=gcc_out.open("w")
         )
-        # IFCC compiler
+        # IFCC compiler, which writes an object instead of the assembly with --object
+        ifcc_output = p / ("obj-ifcc.o" if args.object else "asm-ifcc.s")
+        ifcc_options = (["-c"] if args.object else []) + (["-fstreaming"] if args.streaming else [])
         ifcc_comp = await asyncio.create_subprocess_exec(
-            Path.cwd() /"compiler/ifcc", p / "input.c",
-            stdout=(p / "asm-ifcc.s").open("w"),
+            Path.cwd() /"compiler/ifcc", p / "input.c", *ifcc_options,
+            stdout=ifcc_output.open("wb"),
             stderr=ifcc_out.open("w")
         )
         await gcc_comp.wait()
@@ -155,7 +161,7 @@ async def job(input_file: Path, semaphore: asyncio.Semaphore):
         ifcc_link = await asyncio.create_subprocess_exec(
             "gcc", "-o",
             p / "exe-ifcc",
-            p / "asm-ifcc.s",
+            ifcc_output,
             stderr=ifcc_out.open("w")
         )
         await gcc_link.wait()
@@ -0,0 +1,77 @@
+#!/usr/bin/env python3
+
+# This script checks that the hand-written lexer enabled by -fdfa-lexer produces the same tokens
+# as the lexer generated by ANTLR.
+#
+# Each test-case is lexed twice with `ifcc FILE -dump-tokens`, with and without -fdfa-lexer. The
+# token streams (type, text, position, channel) printed on stdout, the errors printed on stderr
+# and the return codes must be identical.
+
+import argparse
+import difflib
+import os
+import subprocess
+import sys
+import tempfile
+from pathlib import Path
+
+tests_dir = Path(__file__).resolve().parent
+
+argparser = argparse.ArgumentParser(description="Compare the tokens of the ANTLR lexer and of -fdfa-lexer.")
+argparser.add_argument('input', metavar='PATH', nargs='*',
+                       default=[str(tests_dir / "testfiles"), str(tests_dir / "lexer")],
+                       help='test-cases, or directories containing them (default: tests/testfiles and tests/lexer)')
+argparser.add_argument('--ifcc', default=str(tests_dir.parent / "compiler" / "ifcc"), help='path to ifcc')
+argparser.add_argument('-v', '--verbose', action="count", default=0,
+                       help='print the name of each test-case')
+
+args = argparser.parse_args()
+
+input_files = []
+for path_str in args.input:
+    path = Path(path_str)
+    if path.is_file() and path.suffix == '.c':
+        input_files.append(path.resolve())
+    elif path.is_dir():
+        for dirpath, _, filenames in os.walk(path):
+            input_files += [(Path(dirpath) / filename).resolve() for filename in filenames if filename.endswith('.c')]
+    else:
+        print(f"error: cannot read input path: {path}")
+        sys.exit(1)
+
+if not Path(args.ifcc).exists():
+    print(f"error: {args.ifcc} does not exist, run `make build` first")
+    sys.exit(1)
+
+
+def lex(source, work_dir, *flags):
+    result = subprocess.run([args.ifcc, str(source), "-dump-tokens", *flags], cwd=work_dir,
+                            stdout=subprocess.PIPE, stderr=subprocess.PIPE, text=True, errors="replace")
+    return result.returncode, result.stdout, result.stderr
+
+
+failures = []
+with tempfile.TemporaryDirectory(prefix="ifcc-lexer-") as work_dir:
+    for source in sorted(input_files):
+        expected = lex(source, work_dir)
+        actual = lex(source, work_dir, "-fdfa-lexer")
+        if args.verbose:
+            print(("OK   " if actual == expected else "FAIL ") + str(source))
+        else:
+            print("." if actual == expected else "F", end="", flush=True)
+        if actual != expected:
+            failures.append((source, expected, actual))
+
+if not args.verbose:
+    print()
+
+for source, expected, actual in failures:
+    print(f"\nFAIL {source}")
+    if actual[0] != expected[0]:
+        print(f"return code: ANTLR {expected[0]}, -fdfa-lexer {actual[0]}")
+    for name, old, new in (("stdout", expected[1], actual[1]), ("stderr", expected[2], actual[2])):
+        sys.stdout.writelines(difflib.unified_diff(old.splitlines(keepends=True), new.splitlines(keepends=True),
+                                                   f"ANTLR {name}", f"-fdfa-lexer {name}"))
+
+print(f"\n{len(input_files) - len(failures)}/{len(input_files)} test-cases lexed identically")
+sys.exit(1 if failures else 0)
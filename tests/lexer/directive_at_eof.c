@@ -0,0 +1,4 @@
+int main() {
+    return 0;
+}
+#define AT_END_WITHOUT_NEWLINE
\ No newline at end of file
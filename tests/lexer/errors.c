@@ -0,0 +1,13 @@
+int main() {
+    int snake_case = 1;
+    int x = 1 ? 2 : 3;
+    char* p = "unknown escape \q here";
+    char c = 'ab';
+    char e = '';
+    char bad = '\x';
+    float f = 1.5;
+    int $dollar = 2 @ 3 ` ~;
+    return 0;
+}
+/* unterminated comment *
+int after = 1 / * 2;
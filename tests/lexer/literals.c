@@ -0,0 +1,19 @@
+#include <stdio.h>
+#define NOT_A_TOKEN 1 + 2
+/* comment with "a string" and 'c' and /* nested start
+   on several lines ** */
+int main() {
+    char a = 'a', b = '\n', c = '\'', d = '\\', e = '\0', f = ' ', g = '"', h = '/';
+    char i = '\t', j = '\r', k = '\\\\';
+    char* s1 = "";
+    char* s2 = "simple";
+    char* s3 = "with \"escaped\" quotes";
+    char* s4 = "ends with a backslash \\";
+    char* s5 = "\\\\\" odd backslashes";
+    char* s6 = "\n\t\r\0";
+    char* s7 = "multi
+line";
+    char* s8 = "'single' /* not a comment */ // neither";
+    int returned=0123456789;int words123 = 42;int returnValue=1;int iff=2;int whiles=3;
+    return 0;
+}
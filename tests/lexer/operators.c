@@ -0,0 +1,12 @@
+/* Every operator, with and without spaces, including the prefixes of longer operators */
+int main() {
+    int a = 1, b = 2;
+    a+=b;a-=b;a*=b;a/=b;a%=b;a&=b;a^=b;a|=b;
+    a=a+++b;a=a---b;a=-a;a=!a;a=a!=b;a=a==b;a=a>=b;a=a<=b;a=a>b;a=a<b;
+    a=a&&b||a&b|a^b;a=a/b%b*b;
+    a = a+ +b - -b;
+    int* p = &a;
+    a = *p**p;
+    a = a/ /**/ b;
+    return a;
+}
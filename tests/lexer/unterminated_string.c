@@ -0,0 +1,4 @@
+int main() {
+    char* s = "never closed;
+    return 0;
+}
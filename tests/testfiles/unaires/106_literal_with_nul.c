@@ -0,0 +1,6 @@
+int main() {
+    char* test = "ab\0cd";
+    char* test2 = "cd";
+
+    return test[3] + test2[1] + test[4] + test[2];
+}